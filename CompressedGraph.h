@@ -0,0 +1,390 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Varint Helpers ---------------------------------------------
+
+	// LEB128, seven bits per byte with the high bit set on all but the last byte
+	template <class Bytes>
+	inline void encodeVarint(Bytes& bytes, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			bytes.push_back(std::uint8_t(value | 0x80));
+			value >>= 7;
+		}
+		bytes.push_back(std::uint8_t(value));
+	}
+
+	// Advances position past the varint, the encoder guarantees it ends before the stream does
+	inline std::uint64_t decodeVarint(const std::uint8_t*& position) noexcept
+	{
+		std::uint64_t byte = *position++;
+		if (byte < 0x80)
+			return byte;
+		std::uint64_t value = byte & 0x7f;
+		unsigned shift = 7;
+		do
+		{
+			byte = *position++;
+			value |= (byte & 0x7f) << shift;
+			shift += 7;
+		} while (byte >= 0x80);
+		return value;
+	}
+
+	// Maps small negative and positive differences to small unsigned values
+	constexpr std::uint64_t zigzagEncode(std::int64_t value) noexcept { return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63); }
+	constexpr std::int64_t zigzagDecode(std::uint64_t value) noexcept { return std::int64_t(value >> 1) ^ -std::int64_t(value & 1); }
+
+	// Iterators ---------------------------------------------
+
+	template <class Csr>
+	class CompressedCsrVertexIterator;
+
+	// Decodes the neighbor ids of one vertex as it advances, so it holds the stream position and the
+	// current neighbor instead of an index into a neighbor array
+	template <class Csr>
+	class CompressedCsrEdgeIterator
+	{
+	public:
+		using vertex_type					= typename Csr::vertex_type;
+		using weight_type					= typename Csr::weight_type;
+		using edge_reference				= typename Csr::edge_reference;
+		using size_type						= typename Csr::size_type;
+
+		~CompressedCsrEdgeIterator()											= default;
+		CompressedCsrEdgeIterator(const CompressedCsrEdgeIterator&)				= default;
+		CompressedCsrEdgeIterator& operator=(const CompressedCsrEdgeIterator&)	= default;
+
+		friend constexpr bool operator==(const CompressedCsrEdgeIterator& lhs, const CompressedCsrEdgeIterator& rhs) noexcept { return lhs.m_edge == rhs.m_edge; }
+		friend constexpr bool operator!=(const CompressedCsrEdgeIterator& lhs, const CompressedCsrEdgeIterator& rhs) noexcept { return !(lhs == rhs); }
+		CompressedCsrEdgeIterator& operator++()
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("End of iteration reached");
+			if (++m_edge == m_graph->offsets()[m_vertex + 1])
+				m_edge = Csr::npos;
+			else
+				m_target += size_type(decodeVarint(m_position));
+			return *this;
+		}
+		edge_reference operator*() const
+		{
+			if constexpr (Csr::weighted)
+				return edge_reference(source(), target(), weight());
+			else
+				return edge_reference(source(), target());
+		}
+
+		const vertex_type& source() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_vertex];
+		}
+		const vertex_type& target() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_target];
+		}
+		template <bool W = Csr::weighted, std::enable_if_t<W, int> = 0>
+		const weight_type& weight() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->weights()[m_edge];
+		}
+
+		constexpr CompressedCsrVertexIterator<Csr> getStartVertex() const noexcept { return CompressedCsrVertexIterator<Csr>(m_graph, m_vertex); }
+		CompressedCsrVertexIterator<Csr> getEndVertex() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return CompressedCsrVertexIterator<Csr>(m_graph, m_target);
+		}
+
+		friend Csr;
+		friend class CompressedCsrVertexIterator<Csr>;
+	private:
+		// Decodes the first neighbor, which is stored relative to the vertex itself
+		CompressedCsrEdgeIterator(const Csr* graph, size_type vertex) noexcept
+			:m_graph(graph),
+			m_vertex(vertex),
+			m_edge(Csr::npos),
+			m_target(0),
+			m_position(nullptr)
+		{
+			if (graph == nullptr || graph->degree(vertex) == 0)
+				return;
+			m_edge = graph->offsets()[vertex];
+			m_position = graph->bytes().data() + graph->byteOffsets()[vertex];
+			m_target = size_type(std::int64_t(vertex) + zigzagDecode(decodeVarint(m_position)));
+		}
+
+		const Csr* m_graph;
+		size_type m_vertex;
+		size_type m_edge;
+		size_type m_target;
+		const std::uint8_t* m_position;
+	};
+
+	template <class Csr>
+	class CompressedCsrVertexIterator
+	{
+	public:
+		using vertex_type					= typename Csr::vertex_type;
+		using size_type						= typename Csr::size_type;
+
+		~CompressedCsrVertexIterator()												= default;
+		CompressedCsrVertexIterator(const CompressedCsrVertexIterator&)				= default;
+		CompressedCsrVertexIterator& operator=(const CompressedCsrVertexIterator&)	= default;
+
+		friend constexpr bool operator==(const CompressedCsrVertexIterator& lhs, const CompressedCsrVertexIterator& rhs) noexcept { return lhs.m_vertex == rhs.m_vertex; }
+		friend constexpr bool operator!=(const CompressedCsrVertexIterator& lhs, const CompressedCsrVertexIterator& rhs) noexcept { return !(lhs == rhs); }
+		CompressedCsrVertexIterator& operator++()
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("End of iteration reached");
+			if (++m_vertex == m_graph->size())
+				m_vertex = Csr::npos;
+			return *this;
+		}
+		const vertex_type* operator->() const
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return &(m_graph->vertices()[m_vertex]);
+		}
+		const vertex_type& operator*() const
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_vertex];
+		}
+
+		CompressedCsrEdgeIterator<Csr> getEdges() const noexcept { return CompressedCsrEdgeIterator<Csr>(m_graph, m_vertex); }
+
+		constexpr size_type getId() const noexcept { return m_vertex; }
+
+		friend Csr;
+		friend class CompressedCsrEdgeIterator<Csr>;
+	private:
+		constexpr CompressedCsrVertexIterator(const Csr* graph, size_type vertex) noexcept
+			:m_graph(graph),
+			m_vertex(vertex)
+			{}
+
+		const Csr* m_graph;
+		size_type m_vertex;
+	};
+
+	// Read only snapshot like CsrGraph with the neighbor ids of every vertex sorted and gap encoded as
+	// varints. The first neighbor is stored as its zigzagged difference to the vertex, the others as the
+	// difference to the previous neighbor, so graphs with locality, e.g. after a reordering, mostly take
+	// one byte per edge instead of eight. Edges are iterated in target id order rather than the order of
+	// the graph, weights follow their edges.
+	template <class V, bool Directed = false, bool Weighted = false, class Alloc = std::allocator<V>, class Weight = int>
+		class CompressedCsrGraph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+		using allocator_type				= Alloc;
+		using index_allocator_type			= typename allocator_type::template rebind<size_type>::other;
+		using byte_allocator_type			= typename allocator_type::template rebind<std::uint8_t>::other;
+		using weight_allocator_type			= typename allocator_type::template rebind<weight_type>::other;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+
+		using vertex_iterator				= CompressedCsrVertexIterator<CompressedCsrGraph>;
+		using edge_iterator					= CompressedCsrEdgeIterator<CompressedCsrGraph>;
+
+		CompressedCsrGraph()
+			:m_offsets(1, 0),
+			m_byte_offsets(1, 0)
+			{}
+
+		template <class CsrAlloc>
+		explicit CompressedCsrGraph(const CsrGraph<V, Directed, Weighted, CsrAlloc, Weight>& g)
+			:CompressedCsrGraph()
+		{
+			const auto& offsets = g.offsets();
+			const auto& neighbors = g.neighbors();
+			reserveHelper(g.size(), g.edgeCount());
+			std::vector<std::pair<size_type, weight_type>> row;
+			for (size_type vertex = 0; vertex < g.size(); ++vertex)
+			{
+				m_vertices.push_back(g.vertices()[vertex]);
+				for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+					if constexpr (Weighted)
+						row.emplace_back(neighbors[edge], g.weights()[edge]);
+					else
+						row.emplace_back(neighbors[edge], weight_type(0));
+				appendRowHelper(vertex, row);
+			}
+			shrinkHelper();
+		}
+
+		// Encodes straight from the graph without an intermediate CsrGraph
+		template <class VerEq, class Hash, class GraphAlloc, bool InEdges, class Stats>
+		explicit CompressedCsrGraph(const Graph<V, Directed, Weighted, VerEq, Hash, GraphAlloc, Weight, InEdges, Stats>& g)
+			:CompressedCsrGraph()
+		{
+			reserveHelper(g.m_size, g.m_edge_count);
+			std::vector<std::pair<size_type, weight_type>> row;
+			// Walking the id table makes vertices land on the index equal to their id
+			for (auto search : g.m_vertex_nodes)
+			{
+				m_vertices.push_back(search->vertex());
+				for (const auto& edge : search->edges)
+					if constexpr (Weighted)
+						row.emplace_back(edge.vertex_node->id, edge.weight);
+					else
+						row.emplace_back(edge.vertex_node->id, weight_type(0));
+				appendRowHelper(search->id, row);
+			}
+			shrinkHelper();
+		}
+
+		vertex_iterator begin() const noexcept { return vertex_iterator(this, empty() ? npos : 0); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr, npos); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, npos); }
+
+		vertex_iterator vertexAt(size_type id) const
+		{
+			if (id >= size())
+				throw std::out_of_range("Vertex id out of range");
+			return vertex_iterator(this, id);
+		}
+
+		size_type size() const noexcept { return m_vertices.size(); }
+		bool empty() const noexcept { return m_vertices.empty(); }
+		size_type edgeCount() const noexcept { return m_offsets.back(); }
+		size_type degree(size_type id) const noexcept { return m_offsets[id + 1] - m_offsets[id]; }
+		// Size of the encoded neighbor stream in bytes
+		size_type encodedSize() const noexcept { return m_bytes.size(); }
+
+		// Calls visitor(neighbor), or visitor(neighbor, weight) for weighted graphs, for every edge of the
+		// vertex in neighbor order. Cheaper than the edge iterators, which check their state on every step.
+		template <class Visitor>
+		void forEachNeighbor(size_type id, Visitor&& visitor) const
+		{
+			auto edge = m_offsets[id];
+			const auto last = m_offsets[id + 1];
+			if (edge == last)
+				return;
+			const std::uint8_t* position = m_bytes.data() + m_byte_offsets[id];
+			auto neighbor = size_type(std::int64_t(id) + zigzagDecode(decodeVarint(position)));
+			for (;;)
+			{
+				if constexpr (Weighted)
+					visitor(neighbor, m_weights[edge]);
+				else
+					visitor(neighbor);
+				if (++edge == last)
+					break;
+				neighbor += size_type(decodeVarint(position));
+			}
+		}
+
+		// Raw arrays, offsets() holds edge indices like CsrGraph::offsets() and byteOffsets() the start of
+		// every vertex in bytes()
+		const std::vector<vertex_type, allocator_type>& vertices() const noexcept { return m_vertices; }
+		const std::vector<size_type, index_allocator_type>& offsets() const noexcept { return m_offsets; }
+		const std::vector<size_type, index_allocator_type>& byteOffsets() const noexcept { return m_byte_offsets; }
+		const std::vector<std::uint8_t, byte_allocator_type>& bytes() const noexcept { return m_bytes; }
+		// Empty for unweighted graphs, in the order of the sorted edges
+		const std::vector<weight_type, weight_allocator_type>& weights() const noexcept { return m_weights; }
+
+		friend void swap(CompressedCsrGraph& lhs, CompressedCsrGraph& rhs) noexcept
+		{
+			// Enable ADL
+			using std::swap;
+			swap(lhs.m_vertices, rhs.m_vertices);
+			swap(lhs.m_offsets, rhs.m_offsets);
+			swap(lhs.m_byte_offsets, rhs.m_byte_offsets);
+			swap(lhs.m_bytes, rhs.m_bytes);
+			swap(lhs.m_weights, rhs.m_weights);
+		}
+	private:
+		std::vector<vertex_type, allocator_type> m_vertices;
+		std::vector<size_type, index_allocator_type> m_offsets;
+		std::vector<size_type, index_allocator_type> m_byte_offsets;
+		std::vector<std::uint8_t, byte_allocator_type> m_bytes;
+		std::vector<weight_type, weight_allocator_type> m_weights;
+		// Helpers ----------------
+
+		void reserveHelper(size_type vertex_count, size_type edge_count)
+		{
+			m_vertices.reserve(vertex_count);
+			m_offsets.reserve(vertex_count + 1);
+			m_byte_offsets.reserve(vertex_count + 1);
+			// Most gaps of sparse graphs fit in two bytes
+			m_bytes.reserve(2 * edge_count);
+			if constexpr (Weighted)
+				m_weights.reserve(edge_count);
+		}
+
+		// Sorts and encodes the edges of vertex, leaving row empty for the next one
+		void appendRowHelper(size_type vertex, std::vector<std::pair<size_type, weight_type>>& row)
+		{
+			std::sort(row.begin(), row.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+			auto previous = vertex;
+			bool first = true;
+			for (const auto& [neighbor, weight] : row)
+			{
+				if (first)
+					encodeVarint(m_bytes, zigzagEncode(std::int64_t(neighbor) - std::int64_t(vertex)));
+				else
+					encodeVarint(m_bytes, neighbor - previous);
+				first = false;
+				previous = neighbor;
+				if constexpr (Weighted)
+					m_weights.push_back(weight);
+			}
+			m_offsets.push_back(m_offsets.back() + row.size());
+			m_byte_offsets.push_back(m_bytes.size());
+			row.clear();
+		}
+
+		void shrinkHelper() { m_bytes.shrink_to_fit(); }
+
+		// ---------------- Helpers
+	};
+
+	// Takes a compressed snapshot of a graph or a CsrGraph
+	template <class V, bool Directed, bool Weighted, class VerEq, class Hash, class Alloc, class Weight, bool InEdges, class Stats>
+	CompressedCsrGraph<V, Directed, Weighted, Alloc, Weight> compress(const Graph<V, Directed, Weighted, VerEq, Hash, Alloc, Weight, InEdges, Stats>& g)
+	{
+		return CompressedCsrGraph<V, Directed, Weighted, Alloc, Weight>(g);
+	}
+
+	template <class V, bool Directed, bool Weighted, class Alloc, class Weight>
+	CompressedCsrGraph<V, Directed, Weighted, Alloc, Weight> compress(const CsrGraph<V, Directed, Weighted, Alloc, Weight>& g)
+	{
+		return CompressedCsrGraph<V, Directed, Weighted, Alloc, Weight>(g);
+	}
+
+}	// namespace jvn
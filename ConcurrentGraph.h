@@ -0,0 +1,451 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Insert only graph that many threads can fill at once, meant for ingestion before freezing it into a
+	// CsrGraph for the algorithms, see freeze(). Vertex lookups and duplicate edge checks go through a hash
+	// index split into Stripes independently locked stripes. Nodes are published by a CAS onto the head of
+	// the vertex list and of the edge list of their source, so iteration never locks and can run alongside
+	// inserts, seeing a consistent prefix of the graph. Both lists are in reverse insertion order.
+	// Alloc has to be thread safe, std::allocator is, PoolAllocator isn't.
+	template <class V, bool Directed = false, bool Weighted = false,
+		class VerEq = std::equal_to<V>, class Hash = std::hash<V>, class Alloc = std::allocator<V>, class Weight = int,
+		size_t Stripes = 64>
+		class ConcurrentGraph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+		using vertex_equal					= VerEq;
+		using vertex_hash					= Hash;
+		using allocator_type				= Alloc;
+
+		static_assert(Stripes > 0, "The index needs at least one stripe");
+	private:
+		//	Defining Node type traits ------------------------------------------
+
+		//	Forward declare VertexNode
+		struct VertexNode;
+
+		// Immutable once published
+		template <bool W, class Dummy = void>
+		struct EdgeNodeConditional
+		{
+			EdgeNodeConditional(VertexNode* v, weight_type w)
+				:vertex_node(v),
+				weight(w)
+				{}
+			VertexNode* vertex_node			= nullptr;
+			weight_type weight				= weight_type(0);
+			EdgeNodeConditional* next		= nullptr;
+		};
+
+		// Partial rather than explicit specialization, which isn't allowed at class scope
+		template <class Dummy>
+		struct EdgeNodeConditional<false, Dummy>
+		{
+			EdgeNodeConditional(VertexNode* v, weight_type)
+				:vertex_node(v)
+				{}
+			VertexNode* vertex_node			= nullptr;
+			EdgeNodeConditional* next		= nullptr;
+		};
+
+		using EdgeNode						= EdgeNodeConditional<Weighted>;
+
+		struct VertexNode
+		{
+			VertexNode(const vertex_type& v)
+				:vertex(v)
+				{}
+			VertexNode(vertex_type&& v)
+				:vertex(std::move(v))
+				{}
+			vertex_type vertex;
+			std::atomic<EdgeNode*> edge_list	= nullptr;
+			size_type id					= 0;
+			// Set before the node is published and never changed afterwards
+			VertexNode* next				= nullptr;
+		};
+
+		using vertex_node_allocator_type	= typename allocator_type::template rebind<VertexNode>::other;
+		using edge_node_allocator_type		= typename allocator_type::template rebind<EdgeNode>::other;
+
+		//	------------------------------------------ Defining Node type traits
+	private:
+		//	Defining Index type traits -----------------------------------------
+
+		using vertex_key					= std::reference_wrapper<const vertex_type>;
+		using edge_key						= std::pair<const VertexNode*, const VertexNode*>;
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const vertex_key& key) const { return vertex_hash{}(key.get()); }
+		};
+
+		struct VertexKeyEqual
+		{
+			bool operator()(const vertex_key& lhs, const vertex_key& rhs) const { return vertex_equal{}(lhs.get(), rhs.get()); }
+		};
+
+		struct EdgeKeyHash
+		{
+			size_t operator()(const edge_key& key) const
+			{
+				auto seed = std::hash<const VertexNode*>{}(key.first);
+				return seed ^ (std::hash<const VertexNode*>{}(key.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+			}
+		};
+
+		using vertex_index_allocator_type	= typename allocator_type::template rebind<std::pair<const vertex_key, VertexNode*>>::other;
+		using edge_index_allocator_type		= typename allocator_type::template rebind<std::pair<const edge_key, EdgeNode*>>::other;
+
+		// Own cache line per stripe so that threads working on different stripes don't share one
+		struct alignas(64) Stripe
+		{
+			std::mutex mutex;
+			std::unordered_map<vertex_key, VertexNode*, VertexKeyHash, VertexKeyEqual, vertex_index_allocator_type> vertices;
+			std::unordered_map<edge_key, EdgeNode*, EdgeKeyHash, std::equal_to<edge_key>, edge_index_allocator_type> edges;
+		};
+
+		//	----------------------------------------- Defining Index type traits
+	private:
+		//	Defining Iter type traits ------------------------------------------
+
+		// Forward declare VertexIter
+		class VertexIter;
+
+		class EdgeIter
+		{
+		public:
+			~EdgeIter()								= default;
+			EdgeIter(const EdgeIter&)				= default;
+			EdgeIter& operator=(const EdgeIter&)	= default;
+
+			friend constexpr bool operator==(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return lhs.m_edge_node == rhs.m_edge_node; }
+			friend constexpr bool operator!=(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return !(lhs == rhs); }
+			EdgeIter& operator++()
+			{
+				if (m_edge_node == nullptr)
+					throw std::runtime_error("End of iteration reached");
+				m_edge_node = m_edge_node->next;
+				return *this;
+			}
+			edge_reference operator*() const
+			{
+				if constexpr (Weighted)
+					return edge_reference(source(), target(), weight());
+				else
+					return edge_reference(source(), target());
+			}
+
+			const vertex_type& source() const
+			{
+				if (m_edge_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->vertex;
+			}
+			const vertex_type& target() const
+			{
+				if (m_edge_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_edge_node->vertex_node->vertex;
+			}
+			template <bool W = Weighted, std::enable_if_t<W, int> = 0>
+			const weight_type& weight() const
+			{
+				if (m_edge_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_edge_node->weight;
+			}
+
+			constexpr VertexIter getStartVertex() const noexcept { return VertexIter(m_vertex_node); }
+			VertexIter getEndVertex() const
+			{
+				if (m_edge_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return VertexIter(m_edge_node->vertex_node);
+			}
+
+			friend class ConcurrentGraph;
+		private:
+			constexpr EdgeIter(VertexNode* vertex_node, EdgeNode* edge_node) noexcept
+				:m_vertex_node(vertex_node),
+				m_edge_node(edge_node)
+			{}
+
+			VertexNode* m_vertex_node;
+			EdgeNode* m_edge_node;
+		};
+
+		class VertexIter
+		{
+		public:
+			~VertexIter()								= default;
+			VertexIter(const VertexIter&)				= default;
+			VertexIter& operator=(const VertexIter&)	= default;
+
+			friend constexpr bool operator==(const VertexIter& lhs, const VertexIter& rhs) noexcept { return lhs.m_vertex_node == rhs.m_vertex_node; }
+			friend constexpr bool operator!=(const VertexIter& lhs, const VertexIter& rhs) noexcept { return !(lhs == rhs); }
+			VertexIter& operator++()
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("End of iteration reached");
+				m_vertex_node = m_vertex_node->next;
+				return *this;
+			}
+			const vertex_type* operator->() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return &(m_vertex_node->vertex);
+			}
+			const vertex_type& operator*() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->vertex;
+			}
+
+			// Snapshot of the edge list, edges added afterwards aren't seen by this iteration
+			EdgeIter getEdges() const noexcept { return EdgeIter(m_vertex_node, m_vertex_node->edge_list.load(std::memory_order_acquire)); }
+
+			size_type getId() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->id;
+			}
+
+			friend class ConcurrentGraph;
+		private:
+			constexpr VertexIter(VertexNode* vertex_node) noexcept
+				:m_vertex_node(vertex_node)
+				{}
+
+			VertexNode* m_vertex_node;
+		};
+
+		//	------------------------------------------ Defining Iter type traits
+
+	public:
+		using vertex_iterator				= VertexIter;
+		using edge_iterator					= EdgeIter;
+
+	// ------------------------------------------- CONCURRENT GRAPH MAIN LOGIC -------------------------------------------
+	public:
+		ConcurrentGraph()							= default;
+		ConcurrentGraph(const ConcurrentGraph&)				= delete;
+		ConcurrentGraph& operator=(const ConcurrentGraph&)	= delete;
+		~ConcurrentGraph() { destroyGraph(); }
+
+		// Thread safe
+		template <class Ty, std::enable_if_t<std::is_same<std::decay_t<Ty>, vertex_type>::value, int> = 0>
+		std::tuple<vertex_iterator, bool> addVertex(Ty&& vertex)
+		{
+			auto& stripe = m_stripes[VertexKeyHash{}(std::cref(vertex)) % Stripes];
+			std::lock_guard<std::mutex> lock(stripe.mutex);
+
+			auto search = stripe.vertices.find(std::cref(vertex));
+			if (search != stripe.vertices.end())
+				return std::make_tuple(vertex_iterator(search->second), false);
+
+			vertex_node_allocator_type vertex_node_allocator(m_vertex_node_allocator);
+			auto node = vertex_node_allocator.allocate(1);
+			try
+			{
+				vertex_node_allocator.construct(node, std::forward<Ty>(vertex));
+			}
+			catch (...)
+			{
+				vertex_node_allocator.deallocate(node, 1);
+				throw;
+			}
+			try
+			{
+				stripe.vertices.emplace(std::cref(node->vertex), node);
+			}
+			catch (...)
+			{
+				vertex_node_allocator.destroy(node);
+				vertex_node_allocator.deallocate(node, 1);
+				throw;
+			}
+
+			node->id = m_size.fetch_add(1, std::memory_order_relaxed);
+			node->next = m_vertex_node_list.load(std::memory_order_relaxed);
+			while (!m_vertex_node_list.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+			return std::make_tuple(vertex_iterator(node), true);
+		}
+
+		// Thread safe
+		std::tuple<edge_iterator, bool> addEdge(const edge_type& edge)
+		{
+			auto from = std::get<0>(addVertex(std::get<0>(edge))).m_vertex_node;
+			auto to = std::get<0>(addVertex(std::get<1>(edge))).m_vertex_node;
+			auto weight = weight_type(0);
+			if constexpr (Weighted)
+				weight = std::get<2>(edge);
+
+			if constexpr (!Directed)
+				addEdgeHelper(to, from, weight);
+			return addEdgeHelper(from, to, weight);
+		}
+
+		// Thread safe, the stripe of the vertex is locked for the lookup
+		vertex_iterator findVertex(const vertex_type& vertex) const
+		{
+			auto& stripe = m_stripes[VertexKeyHash{}(std::cref(vertex)) % Stripes];
+			std::lock_guard<std::mutex> lock(stripe.mutex);
+			auto search = stripe.vertices.find(std::cref(vertex));
+			return search == stripe.vertices.end() ? end() : vertex_iterator(search->second);
+		}
+
+		// Thread safe, the stripe of the edge is locked for the lookup
+		edge_iterator findEdge(const edge_type& edge) const
+		{
+			auto from = findVertex(std::get<0>(edge)).m_vertex_node;
+			auto to = findVertex(std::get<1>(edge)).m_vertex_node;
+			if (from == nullptr || to == nullptr)
+				return edge_end();
+
+			edge_key key(from, to);
+			auto& stripe = m_stripes[EdgeKeyHash{}(key) % Stripes];
+			std::lock_guard<std::mutex> lock(stripe.mutex);
+			auto search = stripe.edges.find(key);
+			return search == stripe.edges.end() ? edge_end() : edge_iterator(from, search->second);
+		}
+
+		// Lock free, sees every vertex published before the call
+		vertex_iterator begin() const noexcept { return vertex_iterator(m_vertex_node_list.load(std::memory_order_acquire)); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, nullptr); }
+
+		// Exact once the inserting threads are done, a lower bound while they run
+		size_type size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+		size_type edgeCount() const noexcept { return m_edge_count.load(std::memory_order_relaxed); }
+
+		// Takes a CSR snapshot with the vertex ids of the graph and the edges of every vertex in insertion
+		// order. Not thread safe, only call it once the inserting threads are done.
+		friend CsrGraph<vertex_type, Directed, Weighted, allocator_type, weight_type> freeze(const ConcurrentGraph& g)
+		{
+			using csr_type = CsrGraph<vertex_type, Directed, Weighted, allocator_type, weight_type>;
+			const auto vertex_count = g.size();
+			const auto edge_count = g.edgeCount();
+			std::vector<VertexNode*> nodes(vertex_count, nullptr);
+			for (auto search = g.m_vertex_node_list.load(std::memory_order_acquire); search != nullptr; search = search->next)
+				nodes[search->id] = search;
+
+			std::vector<vertex_type, allocator_type> vertices;
+			std::vector<size_type, typename csr_type::index_allocator_type> offsets;
+			std::vector<size_type, typename csr_type::index_allocator_type> neighbors;
+			std::vector<weight_type, typename csr_type::weight_allocator_type> weights;
+			vertices.reserve(vertex_count);
+			offsets.reserve(vertex_count + 1);
+			offsets.push_back(0);
+			neighbors.reserve(edge_count);
+			if constexpr (Weighted)
+				weights.reserve(edge_count);
+
+			// Edge lists are newest first, each row is filled from the back
+			for (auto node : nodes)
+			{
+				vertices.push_back(node->vertex);
+				auto row_first = neighbors.size();
+				for (auto edge_search = node->edge_list.load(std::memory_order_acquire); edge_search != nullptr; edge_search = edge_search->next)
+				{
+					neighbors.push_back(edge_search->vertex_node->id);
+					if constexpr (Weighted)
+						weights.push_back(edge_search->weight);
+				}
+				std::reverse(neighbors.begin() + row_first, neighbors.end());
+				if constexpr (Weighted)
+					std::reverse(weights.begin() + row_first, weights.end());
+				offsets.push_back(neighbors.size());
+			}
+			return csr_type(std::move(vertices), std::move(offsets), std::move(neighbors), std::move(weights));
+		}
+	private:
+		std::atomic<VertexNode*> m_vertex_node_list	= nullptr;
+		std::atomic<size_type> m_size				= 0;
+		std::atomic<size_type> m_edge_count			= 0;
+		mutable Stripe m_stripes[Stripes];
+		vertex_node_allocator_type m_vertex_node_allocator;
+		edge_node_allocator_type m_edge_node_allocator;
+
+		// The stripe lock serializes inserts of the same edge, the CAS orders inserts from the same source
+		// going through different stripes. Readers only ever see fully built nodes.
+		std::tuple<edge_iterator, bool> addEdgeHelper(VertexNode* from, VertexNode* to, weight_type weight)
+		{
+			edge_key key(from, to);
+			auto& stripe = m_stripes[EdgeKeyHash{}(key) % Stripes];
+			std::lock_guard<std::mutex> lock(stripe.mutex);
+
+			auto search = stripe.edges.find(key);
+			if (search != stripe.edges.end())
+				return std::make_tuple(edge_iterator(from, search->second), false);
+
+			edge_node_allocator_type edge_node_allocator(m_edge_node_allocator);
+			auto node = edge_node_allocator.allocate(1);
+			edge_node_allocator.construct(node, to, weight);
+			try
+			{
+				stripe.edges.emplace(key, node);
+			}
+			catch (...)
+			{
+				edge_node_allocator.deallocate(node, 1);
+				throw;
+			}
+
+			node->next = from->edge_list.load(std::memory_order_relaxed);
+			while (!from->edge_list.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+			m_edge_count.fetch_add(1, std::memory_order_relaxed);
+			return std::make_tuple(edge_iterator(from, node), true);
+		}
+
+		// Not thread safe, only called once no other thread uses the graph
+		void destroyGraph()
+		{
+			auto search = m_vertex_node_list.load(std::memory_order_acquire);
+			while (search != nullptr)
+			{
+				auto next = search->next;
+
+				// Deallocate edge list
+				auto edge_search = search->edge_list.load(std::memory_order_relaxed);
+				while (edge_search != nullptr)
+				{
+					auto edge_next = edge_search->next;
+					m_edge_node_allocator.deallocate(edge_search, 1);
+					edge_search = edge_next;
+				}
+
+				m_vertex_node_allocator.destroy(search);
+				m_vertex_node_allocator.deallocate(search, 1);
+				search = next;
+			}
+			m_vertex_node_list.store(nullptr, std::memory_order_relaxed);
+		}
+	};
+
+}	// namespace jvn
@@ -0,0 +1,300 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Graph.h"
+
+namespace jvn
+{
+
+	// Iterators shared by the CSR representations. They only go through the public array accessors
+	// vertices(), offsets(), neighbors(), weights() and size(), so any Csr offering those can use them.
+	template <class Csr>
+	class CsrVertexIterator;
+
+	template <class Csr>
+	class CsrEdgeIterator
+	{
+	public:
+		using vertex_type					= typename Csr::vertex_type;
+		using weight_type					= typename Csr::weight_type;
+		using edge_reference				= typename Csr::edge_reference;
+		using size_type						= typename Csr::size_type;
+
+		~CsrEdgeIterator()									= default;
+		CsrEdgeIterator(const CsrEdgeIterator&)				= default;
+		CsrEdgeIterator& operator=(const CsrEdgeIterator&)	= default;
+
+		friend constexpr bool operator==(const CsrEdgeIterator& lhs, const CsrEdgeIterator& rhs) noexcept { return lhs.m_edge == rhs.m_edge; }
+		friend constexpr bool operator!=(const CsrEdgeIterator& lhs, const CsrEdgeIterator& rhs) noexcept { return !(lhs == rhs); }
+		CsrEdgeIterator& operator++()
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("End of iteration reached");
+			if (++m_edge == m_graph->offsets()[m_vertex + 1])
+				m_edge = Csr::npos;
+			return *this;
+		}
+		edge_reference operator*() const
+		{
+			if constexpr (Csr::weighted)
+				return edge_reference(source(), target(), weight());
+			else
+				return edge_reference(source(), target());
+		}
+
+		const vertex_type& source() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_vertex];
+		}
+		const vertex_type& target() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_graph->neighbors()[m_edge]];
+		}
+		template <bool W = Csr::weighted, std::enable_if_t<W, int> = 0>
+		const weight_type& weight() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->weights()[m_edge];
+		}
+
+		constexpr CsrVertexIterator<Csr> getStartVertex() const noexcept { return CsrVertexIterator<Csr>(m_graph, m_vertex); }
+		CsrVertexIterator<Csr> getEndVertex() const
+		{
+			if (m_edge == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return CsrVertexIterator<Csr>(m_graph, m_graph->neighbors()[m_edge]);
+		}
+
+		friend Csr;
+		friend class CsrVertexIterator<Csr>;
+	private:
+		constexpr CsrEdgeIterator(const Csr* graph, size_type vertex, size_type edge) noexcept
+			:m_graph(graph),
+			m_vertex(vertex),
+			m_edge(edge)
+		{}
+
+		const Csr* m_graph;
+		size_type m_vertex;
+		size_type m_edge;
+	};
+
+	template <class Csr>
+	class CsrVertexIterator
+	{
+	public:
+		using vertex_type					= typename Csr::vertex_type;
+		using size_type						= typename Csr::size_type;
+
+		~CsrVertexIterator()									= default;
+		CsrVertexIterator(const CsrVertexIterator&)				= default;
+		CsrVertexIterator& operator=(const CsrVertexIterator&)	= default;
+
+		friend constexpr bool operator==(const CsrVertexIterator& lhs, const CsrVertexIterator& rhs) noexcept { return lhs.m_vertex == rhs.m_vertex; }
+		friend constexpr bool operator!=(const CsrVertexIterator& lhs, const CsrVertexIterator& rhs) noexcept { return !(lhs == rhs); }
+		CsrVertexIterator& operator++()
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("End of iteration reached");
+			if (++m_vertex == m_graph->size())
+				m_vertex = Csr::npos;
+			return *this;
+		}
+		const vertex_type* operator->() const
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return &(m_graph->vertices()[m_vertex]);
+		}
+		const vertex_type& operator*() const
+		{
+			if (m_vertex == Csr::npos)
+				throw std::runtime_error("Invalid iterator");
+			return m_graph->vertices()[m_vertex];
+		}
+
+		CsrEdgeIterator<Csr> getEdges() const noexcept
+		{
+			auto first = m_graph->offsets()[m_vertex];
+			return CsrEdgeIterator<Csr>(m_graph, m_vertex, first == m_graph->offsets()[m_vertex + 1] ? Csr::npos : first);
+		}
+
+		constexpr size_type getId() const noexcept { return m_vertex; }
+
+		friend Csr;
+		friend class CsrEdgeIterator<Csr>;
+	private:
+		constexpr CsrVertexIterator(const Csr* graph, size_type vertex) noexcept
+			:m_graph(graph),
+			m_vertex(vertex)
+			{}
+
+		const Csr* m_graph;
+		size_type m_vertex;
+	};
+
+	// Immutable compressed sparse row snapshot of a Graph.
+	// Vertices keep the dense ids of the graph they were frozen from, the edges of vertex i are
+	// m_neighbors[m_offsets[i]] ... m_neighbors[m_offsets[i + 1] - 1] in the same order as in the graph.
+	template <class V, bool Directed = false, bool Weighted = false, class Alloc = std::allocator<V>, class Weight = int>
+		class CsrGraph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+		using allocator_type				= Alloc;
+		using index_allocator_type			= typename allocator_type::template rebind<size_type>::other;
+		using weight_allocator_type			= typename allocator_type::template rebind<weight_type>::other;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+
+		using vertex_iterator				= CsrVertexIterator<CsrGraph>;
+		using edge_iterator					= CsrEdgeIterator<CsrGraph>;
+
+	// ------------------------------------------- CSR MAIN LOGIC -------------------------------------------
+	public:
+		CsrGraph()
+			:m_offsets(1, 0)
+			{}
+
+		template <class VerEq, class Hash, class GraphAlloc, bool InEdges, class Stats>
+		explicit CsrGraph(const Graph<V, Directed, Weighted, VerEq, Hash, GraphAlloc, Weight, InEdges, Stats>& g)
+			:CsrGraph()
+		{
+			m_vertices.reserve(g.m_size);
+			m_offsets.reserve(g.m_size + 1);
+
+			m_neighbors.reserve(g.m_edge_count);
+			if constexpr (Weighted)
+				m_weights.reserve(g.m_edge_count);
+
+			// Walking the id table makes vertices land on the index equal to their id
+			for (auto search : g.m_vertex_nodes)
+			{
+				m_vertices.push_back(search->vertex());
+				for (const auto& edge : search->edges)
+				{
+					m_neighbors.push_back(edge.vertex_node->id);
+					if constexpr (Weighted)
+						m_weights.push_back(edge.weight);
+				}
+				m_offsets.push_back(m_neighbors.size());
+			}
+		}
+
+		// Adopts ready made arrays, e.g. from a loader. Throws std::invalid_argument if they don't form a CSR.
+		CsrGraph(std::vector<vertex_type, allocator_type> vertices, std::vector<size_type, index_allocator_type> offsets,
+			std::vector<size_type, index_allocator_type> neighbors, std::vector<weight_type, weight_allocator_type> weights = {})
+			:m_vertices(std::move(vertices)),
+			m_offsets(std::move(offsets)),
+			m_neighbors(std::move(neighbors)),
+			m_weights(std::move(weights))
+		{
+			if (m_offsets.size() != m_vertices.size() + 1 || m_offsets.front() != 0 || m_offsets.back() != m_neighbors.size())
+				throw std::invalid_argument("Offsets don't match the vertex and neighbor arrays");
+			if (!std::is_sorted(m_offsets.begin(), m_offsets.end()))
+				throw std::invalid_argument("Offsets have to be non-decreasing");
+			for (auto neighbor : m_neighbors)
+				if (neighbor >= m_vertices.size())
+					throw std::invalid_argument("Neighbor id out of range");
+			if (m_weights.size() != (Weighted ? m_neighbors.size() : 0))
+				throw std::invalid_argument("Weights don't match the neighbor array");
+		}
+
+		vertex_iterator begin() const noexcept { return vertex_iterator(this, empty() ? npos : 0); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr, npos); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, npos, npos); }
+
+		vertex_iterator vertexAt(size_type id) const
+		{
+			if (id >= size())
+				throw std::out_of_range("Vertex id out of range");
+			return vertex_iterator(this, id);
+		}
+
+		size_type size() const noexcept { return m_vertices.size(); }
+		bool empty() const noexcept { return m_vertices.empty(); }
+		size_type edgeCount() const noexcept { return m_neighbors.size(); }
+		size_type degree(size_type id) const noexcept { return m_offsets[id + 1] - m_offsets[id]; }
+
+		// Raw arrays for algorithms that work on ids directly
+		const std::vector<vertex_type, allocator_type>& vertices() const noexcept { return m_vertices; }
+		const std::vector<size_type, index_allocator_type>& offsets() const noexcept { return m_offsets; }
+		const std::vector<size_type, index_allocator_type>& neighbors() const noexcept { return m_neighbors; }
+		// Empty for unweighted graphs
+		const std::vector<weight_type, weight_allocator_type>& weights() const noexcept { return m_weights; }
+
+		friend void swap(CsrGraph& lhs, CsrGraph& rhs) noexcept
+		{
+			// Enable ADL
+			using std::swap;
+			swap(lhs.m_vertices, rhs.m_vertices);
+			swap(lhs.m_offsets, rhs.m_offsets);
+			swap(lhs.m_neighbors, rhs.m_neighbors);
+			swap(lhs.m_weights, rhs.m_weights);
+		}
+	private:
+		std::vector<vertex_type, allocator_type> m_vertices;
+		std::vector<size_type, index_allocator_type> m_offsets;
+		std::vector<size_type, index_allocator_type> m_neighbors;
+		std::vector<weight_type, weight_allocator_type> m_weights;
+	};
+
+	// Index of the lowest set bit of a non-zero word
+	inline size_t lowestSetBit(std::uint64_t bits) noexcept
+	{
+#if defined(__GNUC__)
+		return size_t(__builtin_ctzll(bits));
+#else
+		size_t bit = 0;
+		for (; !((bits >> bit) & 1); ++bit);
+		return bit;
+#endif
+	}
+
+	// Cuts the vertices into count ranges of about the same number of vertices plus edges, so hubs don't
+	// leave one task with most of the work. Returns count + 1 boundaries.
+	template <class Offsets>
+	std::vector<size_t> balancedVertexRanges(const Offsets& offsets, size_t count)
+	{
+		const auto vertex_count = offsets.size() - 1;
+		const auto total = vertex_count + offsets.back();
+		std::vector<size_t> bounds(count + 1, vertex_count);
+		bounds[0] = 0;
+		size_t vertex = 0;
+		for (size_t range = 1; range < count; ++range)
+		{
+			const auto target = total / count * range + total % count * range / count;
+			while (vertex < vertex_count && vertex + offsets[vertex] < target)
+				++vertex;
+			bounds[range] = vertex;
+		}
+		return bounds;
+	}
+
+	// Takes an immutable CSR snapshot of the graph, the graph itself is left untouched
+	template <class V, bool Directed, bool Weighted, class VerEq, class Hash, class Alloc, class Weight, bool InEdges, class Stats>
+	CsrGraph<V, Directed, Weighted, Alloc, Weight> freeze(const Graph<V, Directed, Weighted, VerEq, Hash, Alloc, Weight, InEdges, Stats>& g)
+	{
+		return CsrGraph<V, Directed, Weighted, Alloc, Weight>(g);
+	}
+
+}	// namespace jvn
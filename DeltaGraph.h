@@ -0,0 +1,744 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+#include "Graph.h"
+#include "Reordering.h"
+
+namespace jvn
+{
+
+	// Frozen CSR base plus a small overlay of edges added since, for graphs that keep growing while they
+	// are queried. The overlay is a Graph over vertex ids, so new edges go into the usual linked edge
+	// lists instead of forcing a rebuild, and compact() folds it into a new base.
+	// Readers work on a Snapshot: an epoch of immutable layers that stays valid, and unchanged, for as long
+	// as it is held. Writers fill a private pending overlay that publish() seals into a new layer visible to
+	// new snapshots, compaction swaps in the new base the same way, so neither ever waits for a reader.
+	// Layers are merged like a binary counter while the newest one is at least half the size of the one
+	// before, so an epoch holds O(log E) layers and publishing costs O(log E) amortized per edge instead of
+	// a copy of the whole overlay.
+	// Ids are dense and never change: base vertices keep theirs, new vertices are numbered after them.
+	// All members are thread safe, writers are serialized among each other.
+	template <class V, bool Directed = false, bool Weighted = false,
+		class VerEq = std::equal_to<V>, class Hash = std::hash<V>, class Weight = int>
+		class DeltaCsrGraph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+		using vertex_equal					= VerEq;
+		using vertex_hash					= Hash;
+		using csr_type						= CsrGraph<V, Directed, Weighted, std::allocator<V>, Weight>;
+		// Vertices are the ids of the graph, so base vertices with new edges aren't copied
+		using overlay_type					= Graph<size_type, Directed, Weighted, std::equal_to<size_type>,
+											std::hash<size_type>, std::allocator<size_type>, Weight>;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+	private:
+		//	Defining Layer type traits -----------------------------------------
+
+		using vertex_index_type				= std::unordered_map<vertex_type, size_type, vertex_hash, vertex_equal>;
+
+		// Rows are sorted by target so edge lookups are binary searches
+		struct Base
+		{
+			csr_type csr;
+			vertex_index_type index;
+		};
+
+		struct Delta
+		{
+			overlay_type edges;
+			// Vertices new in this layer, with the ids first_id ... first_id + vertices.size() - 1
+			std::vector<vertex_type> vertices;
+			vertex_index_type index;
+			size_type first_id				= 0;
+
+			size_type endId() const noexcept { return first_id + vertices.size(); }
+		};
+
+		using layer_list					= std::vector<std::shared_ptr<const Delta>>;
+
+		// What a snapshot sees, the base and the published layers oldest first. Each layer numbers its new
+		// vertices where the one before stopped.
+		struct Epoch
+		{
+			std::shared_ptr<const Base> base;
+			layer_list layers;
+
+			size_type size() const noexcept { return layers.empty() ? base->csr.size() : layers.back()->endId(); }
+
+			const vertex_type& vertex(size_type id) const
+			{
+				if (id < base->csr.size())
+					return base->csr.vertices()[id];
+				auto search = std::upper_bound(layers.begin(), layers.end(), id,
+					[](size_type id, const std::shared_ptr<const Delta>& layer) { return id < layer->endId(); });
+				return (*search)->vertices[id - (*search)->first_id];
+			}
+
+			size_type findVertex(const vertex_type& vertex) const
+			{
+				auto search = base->index.find(vertex);
+				if (search != base->index.end())
+					return search->second;
+				for (const auto& layer : layers)
+				{
+					auto layer_search = layer->index.find(vertex);
+					if (layer_search != layer->index.end())
+						return layer_search->second;
+				}
+				return npos;
+			}
+		};
+
+		//	----------------------------------------- Defining Layer type traits
+	private:
+		//	Defining Iter type traits ------------------------------------------
+
+		// Forward declare VertexIter
+		class VertexIter;
+
+		// Walks the base row of a vertex, then its edges in every layer from the oldest to the newest
+		class EdgeIter
+		{
+		public:
+			~EdgeIter()								= default;
+			EdgeIter(const EdgeIter&)				= default;
+			EdgeIter& operator=(const EdgeIter&)	= default;
+
+			friend bool operator==(const EdgeIter& lhs, const EdgeIter& rhs) noexcept
+			{
+				return lhs.m_vertex == rhs.m_vertex && lhs.m_layer == rhs.m_layer && lhs.m_edge == rhs.m_edge
+					&& lhs.m_overlay_edge == rhs.m_overlay_edge;
+			}
+			friend bool operator!=(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return !(lhs == rhs); }
+			EdgeIter& operator++()
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("End of iteration reached");
+				if (m_layer == base_layer)
+					++m_edge;
+				else
+					++m_overlay_edge;
+				settle();
+				return *this;
+			}
+			edge_reference operator*() const
+			{
+				if constexpr (Weighted)
+					return edge_reference(source(), target(), weight());
+				else
+					return edge_reference(source(), target());
+			}
+
+			const vertex_type& source() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_epoch->vertex(m_vertex);
+			}
+			const vertex_type& target() const { return m_epoch->vertex(targetId()); }
+			template <bool W = Weighted, std::enable_if_t<W, int> = 0>
+			const weight_type& weight() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				if (m_layer == base_layer)
+					return m_epoch->base->csr.weights()[m_edge];
+				return m_overlay_edge.weight();
+			}
+
+			size_type targetId() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				if (m_layer == base_layer)
+					return m_epoch->base->csr.neighbors()[m_edge];
+				return m_overlay_edge.target();
+			}
+
+			VertexIter getStartVertex() const noexcept { return VertexIter(m_epoch, m_vertex); }
+			VertexIter getEndVertex() const { return VertexIter(m_epoch, targetId()); }
+
+			friend class DeltaCsrGraph;
+		private:
+			// Layer i of the epoch is m_layer i + 1
+			static constexpr size_type base_layer = 0;
+			static constexpr size_type end_layer = npos;
+
+			EdgeIter() noexcept
+				:m_epoch(nullptr),
+				m_vertex(npos),
+				m_layer(end_layer),
+				m_edge(0),
+				m_overlay_edge(overlay_type::edge_end())
+			{}
+
+			EdgeIter(const Epoch* epoch, size_type vertex, size_type layer, size_type edge,
+				typename overlay_type::edge_iterator overlay_edge = overlay_type::edge_end()) noexcept
+				:m_epoch(epoch),
+				m_vertex(vertex),
+				m_layer(layer),
+				m_edge(edge),
+				m_overlay_edge(overlay_edge)
+			{}
+
+			// Moves on to the next layer with edges left, or to the end
+			void settle()
+			{
+				while (true)
+				{
+					if (m_layer == base_layer)
+					{
+						const auto& csr = m_epoch->base->csr;
+						if (m_vertex < csr.size() && m_edge < csr.offsets()[m_vertex + 1])
+							return;
+						enterOverlay(base_layer + 1);
+					}
+					else if (m_overlay_edge != overlay_type::edge_end())
+						return;
+					else if (m_layer < m_epoch->layers.size())
+						enterOverlay(m_layer + 1);
+					else
+					{
+						*this = EdgeIter();
+						return;
+					}
+				}
+			}
+
+			void enterOverlay(size_type layer)
+			{
+				m_layer = layer;
+				m_edge = 0;
+				m_overlay_edge = overlay_type::edge_end();
+				if (layer > m_epoch->layers.size())
+					return;
+				const auto& delta = *m_epoch->layers[layer - 1];
+				auto search = delta.edges.findVertex(m_vertex);
+				if (search != delta.edges.end())
+					m_overlay_edge = search.getEdges();
+			}
+
+			const Epoch* m_epoch;
+			size_type m_vertex;
+			size_type m_layer;
+			size_type m_edge;
+			typename overlay_type::edge_iterator m_overlay_edge;
+		};
+
+		// Visits the vertices by id
+		class VertexIter
+		{
+		public:
+			~VertexIter()								= default;
+			VertexIter(const VertexIter&)				= default;
+			VertexIter& operator=(const VertexIter&)	= default;
+
+			friend constexpr bool operator==(const VertexIter& lhs, const VertexIter& rhs) noexcept { return lhs.m_vertex == rhs.m_vertex; }
+			friend constexpr bool operator!=(const VertexIter& lhs, const VertexIter& rhs) noexcept { return !(lhs == rhs); }
+			VertexIter& operator++()
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("End of iteration reached");
+				if (++m_vertex == m_epoch->size())
+					m_vertex = npos;
+				return *this;
+			}
+			const vertex_type* operator->() const { return &operator*(); }
+			const vertex_type& operator*() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_epoch->vertex(m_vertex);
+			}
+
+			EdgeIter getEdges() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				EdgeIter edge(m_epoch, m_vertex, EdgeIter::base_layer,
+					m_vertex < m_epoch->base->csr.size() ? m_epoch->base->csr.offsets()[m_vertex] : 0);
+				edge.settle();
+				return edge;
+			}
+
+			constexpr size_type getId() const noexcept { return m_vertex; }
+
+			friend class DeltaCsrGraph;
+		private:
+			constexpr VertexIter(const Epoch* epoch, size_type vertex) noexcept
+				:m_epoch(epoch),
+				m_vertex(vertex)
+				{}
+
+			const Epoch* m_epoch;
+			size_type m_vertex;
+		};
+
+		//	------------------------------------------ Defining Iter type traits
+
+	public:
+		using vertex_iterator				= VertexIter;
+		using edge_iterator					= EdgeIter;
+
+		// Immutable view of the graph as of the last publish before it was taken. Iterators point into the
+		// snapshot and have to be dropped with it.
+		class Snapshot
+		{
+		public:
+			vertex_iterator begin() const noexcept { return vertex_iterator(m_epoch.get(), size() == 0 ? npos : 0); }
+			static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr, npos); }
+			static edge_iterator edge_end() noexcept { return edge_iterator(); }
+
+			vertex_iterator vertexAt(size_type id) const
+			{
+				if (id >= size())
+					throw std::out_of_range("Vertex id out of range");
+				return vertex_iterator(m_epoch.get(), id);
+			}
+
+			vertex_iterator findVertex(const vertex_type& vertex) const
+			{
+				auto id = m_epoch->findVertex(vertex);
+				return id == npos ? end() : vertex_iterator(m_epoch.get(), id);
+			}
+
+			// The weight isn't compared
+			edge_iterator findEdge(const edge_type& edge) const
+			{
+				auto from = m_epoch->findVertex(std::get<0>(edge));
+				auto to = m_epoch->findVertex(std::get<1>(edge));
+				if (from == npos || to == npos)
+					return edge_end();
+				return findEdgeHelper(*m_epoch, from, to);
+			}
+
+			size_type size() const noexcept { return m_epoch->size(); }
+			bool empty() const noexcept { return size() == 0; }
+			// Counts both directions of undirected edges, like CsrGraph
+			size_type edgeCount() const noexcept
+			{
+				auto count = m_epoch->base->csr.edgeCount();
+				for (const auto& layer : m_epoch->layers)
+					count += layer->edges.edgeCount();
+				return count;
+			}
+			size_type degree(size_type id) const
+			{
+				if (id >= size())
+					throw std::out_of_range("Vertex id out of range");
+				const auto& csr = m_epoch->base->csr;
+				size_type degree = id < csr.size() ? csr.degree(id) : 0;
+				for (const auto& layer : m_epoch->layers)
+				{
+					auto search = layer->edges.findVertex(id);
+					if (search != layer->edges.end())
+						degree += layer->edges.degree(search);
+				}
+				return degree;
+			}
+
+			// The frozen part without the overlay, e.g. for the CSR algorithms
+			const csr_type& base() const noexcept { return m_epoch->base->csr; }
+			// Number of edges not yet folded into the base, a hint for when to compact
+			size_type overlayEdgeCount() const noexcept { return edgeCount() - base().edgeCount(); }
+
+			friend class DeltaCsrGraph;
+		private:
+			explicit Snapshot(std::shared_ptr<const Epoch> epoch) noexcept
+				:m_epoch(std::move(epoch))
+				{}
+
+			std::shared_ptr<const Epoch> m_epoch;
+		};
+
+	// ------------------------------------------- DELTA GRAPH MAIN LOGIC -------------------------------------------
+	public:
+		DeltaCsrGraph() : DeltaCsrGraph(csr_type()) {}
+		// Adopts the snapshot as the first base, sorting its rows
+		explicit DeltaCsrGraph(const csr_type& base)
+		{
+			auto first = std::make_shared<Base>();
+			std::vector<size_type> identity(base.size());
+			for (size_type id = 0; id < identity.size(); ++id)
+				identity[id] = id;
+			first->csr = permute(base, identity);
+			first->index.reserve(base.size());
+			for (size_type id = 0; id < base.size(); ++id)
+				if (!first->index.emplace(base.vertices()[id], id).second)
+					throw std::invalid_argument("Duplicate vertex in the base snapshot");
+			m_base = std::move(first);
+			m_pending.first_id = m_base->csr.size();
+			publishHelper();
+		}
+		template <class GraphVerEq, class GraphHash, class Alloc, bool InEdges, class Stats>
+		explicit DeltaCsrGraph(const Graph<V, Directed, Weighted, GraphVerEq, GraphHash, Alloc, Weight, InEdges, Stats>& g)
+			:DeltaCsrGraph(csr_type(g))
+			{}
+		DeltaCsrGraph(const DeltaCsrGraph&)				= delete;
+		DeltaCsrGraph& operator=(const DeltaCsrGraph&)	= delete;
+		// Waits for the compactions started by compactAsync
+		~DeltaCsrGraph()
+		{
+			std::unique_lock<std::mutex> lock(m_async_mutex);
+			m_async_done.wait(lock, [this] { return m_async_count == 0; });
+		}
+
+		// Loads the epoch with std::atomic_load, which standard libraries implement with a lock, libstdc++
+		// with a global pool of mutexes, so taking a snapshot can briefly wait for a publish. Reading the
+		// snapshot never locks.
+		Snapshot snapshot() const { return Snapshot(std::atomic_load(&m_epoch)); }
+
+		// Returns the id of the vertex and whether it was added. Pending until publish.
+		std::tuple<size_type, bool> addVertex(const vertex_type& vertex)
+		{
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			return addVertexHelper(vertex);
+		}
+
+		// Returns whether the edge was added, an edge already in any layer isn't. Pending until publish.
+		bool addEdge(const edge_type& edge)
+		{
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			return addEdgeHelper(edge);
+		}
+
+		// Adds and publishes a batch, the publish costs O(log E) amortized per edge of the batch
+		template <class InputIt>
+		void addEdges(InputIt first, InputIt last)
+		{
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			for (; first != last; ++first)
+				addEdgeHelper(*first);
+			publishHelper();
+		}
+
+		// Makes the pending vertices and edges visible to snapshots taken from now on
+		void publish()
+		{
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			publishHelper();
+		}
+
+		// Publishes, then folds every published layer into a new base and swaps it in. The O(V + E) merge
+		// runs without blocking writers or readers, edges published meanwhile land in layers of their own.
+		// Concurrent compactions run one after the other.
+		void compact()
+		{
+			std::lock_guard<std::mutex> compact_lock(m_compact_mutex);
+			std::shared_ptr<const Base> base;
+			layer_list sealed;
+			{
+				std::lock_guard<std::mutex> lock(m_write_mutex);
+				sealPendingHelper();
+				if (m_layers.empty())
+					return;
+				publishHelper();
+				m_sealed_count = m_layers.size();
+				base = m_base;
+				sealed = m_layers;
+			}
+
+			auto folded = foldHelper(*base, sealed);
+
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			m_base = std::move(folded);
+			m_layers.erase(m_layers.begin(), m_layers.begin() + m_sealed_count);
+			m_sealed_count = 0;
+			publishHelper();
+		}
+
+		// compact() on a detached thread. The future only reports the outcome, dropping it doesn't wait for
+		// the compaction, destroying the graph does.
+		std::future<void> compactAsync()
+		{
+			std::packaged_task<void()> task([this]
+			{
+				try
+				{
+					compact();
+				}
+				catch (...)
+				{
+					finishAsyncHelper();
+					throw;
+				}
+				finishAsyncHelper();
+			});
+			auto result = task.get_future();
+
+			std::lock_guard<std::mutex> lock(m_async_mutex);
+			std::thread(std::move(task)).detach();
+			++m_async_count;
+			return result;
+		}
+	private:
+		// Guards the pending layer and the layers it is checked against
+		mutable std::mutex m_write_mutex;
+		std::mutex m_compact_mutex;
+		std::shared_ptr<const Base> m_base;
+		// Published layers oldest first, the first m_sealed_count are being folded by a compaction
+		layer_list m_layers;
+		size_type m_sealed_count			= 0;
+		Delta m_pending;
+		// Only accessed through the atomic shared_ptr functions
+		std::shared_ptr<const Epoch> m_epoch;
+		// Compactions of compactAsync still running, the last one to finish wakes the destructor
+		std::mutex m_async_mutex;
+		std::condition_variable m_async_done;
+		size_type m_async_count				= 0;
+
+		// Helpers ----------------
+
+		void finishAsyncHelper() noexcept
+		{
+			std::lock_guard<std::mutex> lock(m_async_mutex);
+			if (--m_async_count == 0)
+				m_async_done.notify_all();
+		}
+
+		static edge_iterator findEdgeHelper(const Epoch& epoch, size_type from, size_type to)
+		{
+			const auto& csr = epoch.base->csr;
+			if (from < csr.size() && to < csr.size())
+			{
+				auto first = csr.neighbors().begin() + csr.offsets()[from];
+				auto last = csr.neighbors().begin() + csr.offsets()[from + 1];
+				auto search = std::lower_bound(first, last, to);
+				if (search != last && *search == to)
+					return edge_iterator(&epoch, from, edge_iterator::base_layer, size_type(search - csr.neighbors().begin()));
+			}
+			for (size_type layer = 0; layer < epoch.layers.size(); ++layer)
+			{
+				auto search = findOverlayEdgeHelper(epoch.layers[layer]->edges, from, to);
+				if (search != overlay_type::edge_end())
+					return edge_iterator(&epoch, from, edge_iterator::base_layer + 1 + layer, 0, search);
+			}
+			return edge_iterator();
+		}
+
+		static typename overlay_type::edge_iterator findOverlayEdgeHelper(const overlay_type& edges, size_type from, size_type to)
+		{
+			if constexpr (Weighted)
+				return edges.findEdge({ from, to, weight_type(0) });
+			else
+				return edges.findEdge({ from, to });
+		}
+
+		std::tuple<size_type, bool> addVertexHelper(const vertex_type& vertex)
+		{
+			auto search = m_base->index.find(vertex);
+			if (search != m_base->index.end())
+				return std::make_tuple(search->second, false);
+			for (const auto& layer : m_layers)
+			{
+				auto layer_search = layer->index.find(vertex);
+				if (layer_search != layer->index.end())
+					return std::make_tuple(layer_search->second, false);
+			}
+			auto pending_search = m_pending.index.find(vertex);
+			if (pending_search != m_pending.index.end())
+				return std::make_tuple(pending_search->second, false);
+			auto id = m_pending.endId();
+			m_pending.vertices.push_back(vertex);
+			try
+			{
+				m_pending.index.emplace(vertex, id);
+			}
+			catch (...)
+			{
+				m_pending.vertices.pop_back();
+				throw;
+			}
+			return std::make_tuple(id, true);
+		}
+
+		bool addEdgeHelper(const edge_type& edge)
+		{
+			auto from = std::get<0>(addVertexHelper(std::get<0>(edge)));
+			auto to = std::get<0>(addVertexHelper(std::get<1>(edge)));
+
+			// Duplicates within the pending layer are caught by its addEdge
+			const auto& csr = m_base->csr;
+			if (from < csr.size() && to < csr.size())
+			{
+				auto first = csr.neighbors().begin() + csr.offsets()[from];
+				auto last = csr.neighbors().begin() + csr.offsets()[from + 1];
+				if (std::binary_search(first, last, to))
+					return false;
+			}
+			for (const auto& layer : m_layers)
+				if (findOverlayEdgeHelper(layer->edges, from, to) != overlay_type::edge_end())
+					return false;
+
+			if constexpr (Weighted)
+				return std::get<1>(m_pending.edges.addEdge({ from, to, std::get<2>(edge) }));
+			else
+				return std::get<1>(m_pending.edges.addEdge({ from, to }));
+		}
+
+		// Makes the pending vertices and edges a layer of their own, without copying them
+		void sealPendingHelper()
+		{
+			if (m_pending.vertices.empty() && m_pending.edges.size() == 0)
+				return;
+			auto first_id = m_pending.endId();
+			m_layers.push_back(std::make_shared<const Delta>(std::move(m_pending)));
+			m_pending = Delta();
+			m_pending.first_id = first_id;
+
+			// Layers a compaction is folding stay as they are
+			while (m_layers.size() >= m_sealed_count + 2
+				&& layerSize(*m_layers[m_layers.size() - 2]) < 2 * layerSize(*m_layers.back()))
+			{
+				auto merged = mergeLayersHelper(*m_layers[m_layers.size() - 2], *m_layers.back());
+				m_layers.pop_back();
+				m_layers.back() = std::move(merged);
+			}
+		}
+
+		static size_type layerSize(const Delta& layer) noexcept { return layer.vertices.size() + layer.edges.edgeCount(); }
+
+		// The newer layer only holds edges and vertices that aren't in the older one
+		static std::shared_ptr<const Delta> mergeLayersHelper(const Delta& older, const Delta& newer)
+		{
+			auto merged = std::make_shared<Delta>();
+			merged->edges = older.edges;
+			merged->vertices = older.vertices;
+			merged->vertices.insert(merged->vertices.end(), newer.vertices.begin(), newer.vertices.end());
+			merged->index = older.index;
+			merged->index.insert(newer.index.begin(), newer.index.end());
+			merged->first_id = older.first_id;
+			for (auto vertex = newer.edges.begin(); vertex != newer.edges.end(); ++vertex)
+				for (auto edge = vertex.getEdges(); edge != newer.edges.edge_end(); ++edge)
+				{
+					// The mirrored half of an undirected edge comes with its other half
+					if (!Directed && edge.target() < edge.source())
+						continue;
+					if constexpr (Weighted)
+						merged->edges.addEdge({ edge.source(), edge.target(), edge.weight() });
+					else
+						merged->edges.addEdge({ edge.source(), edge.target() });
+				}
+			return merged;
+		}
+
+		void publishHelper()
+		{
+			sealPendingHelper();
+			auto epoch = std::make_shared<Epoch>();
+			epoch->base = m_base;
+			epoch->layers = m_layers;
+			std::atomic_store(&m_epoch, std::shared_ptr<const Epoch>(std::move(epoch)));
+		}
+
+		// Merges every row of the base with the edges of the vertex in the sealed layers, appending the
+		// vertices that are new in them
+		static std::shared_ptr<const Base> foldHelper(const Base& base, const layer_list& sealed)
+		{
+			const auto& csr = base.csr;
+			const auto& offsets = csr.offsets();
+			const auto& neighbors = csr.neighbors();
+			const auto& weights = csr.weights();
+			const auto vertex_count = sealed.back()->endId();
+			auto edge_count = csr.edgeCount();
+			for (const auto& layer : sealed)
+				edge_count += layer->edges.edgeCount();
+
+			std::vector<vertex_type> vertices;
+			std::vector<size_type> new_offsets;
+			std::vector<size_type> new_neighbors;
+			std::vector<weight_type> new_weights;
+			vertices.reserve(vertex_count);
+			new_offsets.reserve(vertex_count + 1);
+			new_neighbors.reserve(edge_count);
+			if constexpr (Weighted)
+				new_weights.reserve(edge_count);
+
+			std::vector<std::pair<size_type, weight_type>> row;
+			new_offsets.push_back(0);
+			size_type vertex_layer = 0;
+			for (size_type id = 0; id < vertex_count; ++id)
+			{
+				if (id < csr.size())
+					vertices.push_back(csr.vertices()[id]);
+				else
+				{
+					while (id >= sealed[vertex_layer]->endId())
+						++vertex_layer;
+					vertices.push_back(sealed[vertex_layer]->vertices[id - sealed[vertex_layer]->first_id]);
+				}
+
+				row.clear();
+				for (const auto& layer : sealed)
+				{
+					auto search = layer->edges.findVertex(id);
+					if (search == layer->edges.end())
+						continue;
+					for (auto edge = search.getEdges(); edge != layer->edges.edge_end(); ++edge)
+					{
+						if constexpr (Weighted)
+							row.emplace_back(edge.target(), edge.weight());
+						else
+							row.emplace_back(edge.target(), weight_type(0));
+					}
+				}
+				std::sort(row.begin(), row.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+				// Both sides are sorted and disjoint, a merge keeps the row sorted
+				auto base_edge = id < csr.size() ? offsets[id] : 0;
+				auto base_last = id < csr.size() ? offsets[id + 1] : 0;
+				auto overlay_edge = row.begin();
+				while (base_edge != base_last || overlay_edge != row.end())
+				{
+					if (overlay_edge == row.end() || (base_edge != base_last && neighbors[base_edge] < overlay_edge->first))
+					{
+						new_neighbors.push_back(neighbors[base_edge]);
+						if constexpr (Weighted)
+							new_weights.push_back(weights[base_edge]);
+						++base_edge;
+					}
+					else
+					{
+						new_neighbors.push_back(overlay_edge->first);
+						if constexpr (Weighted)
+							new_weights.push_back(overlay_edge->second);
+						++overlay_edge;
+					}
+				}
+				new_offsets.push_back(new_neighbors.size());
+			}
+
+			auto folded = std::make_shared<Base>();
+			folded->csr = csr_type(std::move(vertices), std::move(new_offsets), std::move(new_neighbors), std::move(new_weights));
+			folded->index = base.index;
+			for (const auto& layer : sealed)
+				folded->index.insert(layer->index.begin(), layer->index.end());
+			return folded;
+		}
+	};
+
+}	// namespace jvn
@@ -0,0 +1,450 @@
+#pragma once
+// For std::...
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Graph over the vertices 0 ... size() - 1. A vertex is the index of its slot, so there is no vertex
+	// storage, hashing or equality test and finding a vertex is a bounds check. Adding an edge grows the
+	// graph to cover both ends. Since ids are positions vertices can't be removed, edges can.
+	// Iterators dereference to ids by value rather than to references.
+	template <bool Directed = false, bool Weighted = false, class Weight = int, class Alloc = std::allocator<size_t>>
+		class DenseGraph
+	{
+	public:
+		using vertex_type					= size_t;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, const weight_type&>,
+											std::tuple<vertex_type, vertex_type>>;
+		using size_type						= size_t;
+		using allocator_type				= Alloc;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+	private:
+		//	Defining Slot type traits ------------------------------------------
+
+		template <bool W, class Dummy = void>
+		struct EdgeSlotConditional
+		{
+			EdgeSlotConditional(size_type t, weight_type w)
+				:target(t),
+				weight(w)
+				{}
+			size_type target;
+			weight_type weight;
+		};
+
+		template <class Dummy>
+		struct EdgeSlotConditional<false, Dummy>
+		{
+			EdgeSlotConditional(size_type t, weight_type)
+				:target(t)
+				{}
+			size_type target;
+		};
+
+		using EdgeSlot						= EdgeSlotConditional<Weighted>;
+		using edge_slot_allocator_type		= typename allocator_type::template rebind<EdgeSlot>::other;
+		// Maps a target to its position in the edge array, built once the degree passes edge_index_threshold
+		using edge_index_allocator_type		= typename allocator_type::template rebind<std::pair<const size_type, size_type>>::other;
+		using EdgeIndex						= std::unordered_map<size_type, size_type, std::hash<size_type>,
+											std::equal_to<size_type>, edge_index_allocator_type>;
+
+		static constexpr size_type edge_index_threshold = 16;
+
+		// Slots take the allocator of the slot array, so with an arena allocator all of them share one arena
+		struct VertexSlot
+		{
+			explicit VertexSlot(const edge_slot_allocator_type& allocator)
+				:edges(allocator)
+				{}
+			VertexSlot(VertexSlot&&)				= default;
+			VertexSlot& operator=(VertexSlot&&)		= default;
+			VertexSlot(const VertexSlot& slot)
+				:edges(slot.edges),
+				edge_index(slot.edge_index ? std::make_unique<EdgeIndex>(*slot.edge_index) : nullptr)
+				{}
+			VertexSlot& operator=(const VertexSlot& slot)
+			{
+				VertexSlot copy(slot);
+				return *this = std::move(copy);
+			}
+
+			std::vector<EdgeSlot, edge_slot_allocator_type> edges;
+			std::unique_ptr<EdgeIndex> edge_index;
+		};
+
+		using vertex_slot_allocator_type	= typename allocator_type::template rebind<VertexSlot>::other;
+
+		//	------------------------------------------ Defining Slot type traits
+	private:
+		//	Defining Iter type traits ------------------------------------------
+
+		// Forward declare VertexIter
+		class VertexIter;
+
+		class EdgeIter
+		{
+		public:
+			~EdgeIter()								= default;
+			EdgeIter(const EdgeIter&)				= default;
+			EdgeIter& operator=(const EdgeIter&)	= default;
+
+			friend constexpr bool operator==(const EdgeIter& lhs, const EdgeIter& rhs) noexcept
+			{ return lhs.m_vertex == rhs.m_vertex && lhs.m_edge == rhs.m_edge; }
+			friend constexpr bool operator!=(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return !(lhs == rhs); }
+			EdgeIter& operator++()
+			{
+				if (m_edge == npos)
+					throw std::runtime_error("End of iteration reached");
+				if (++m_edge == m_graph->m_slots[m_vertex].edges.size())
+				{
+					m_vertex = npos;
+					m_edge = npos;
+				}
+				return *this;
+			}
+			edge_reference operator*() const
+			{
+				if constexpr (Weighted)
+					return edge_reference(source(), target(), weight());
+				else
+					return edge_reference(source(), target());
+			}
+
+			vertex_type source() const
+			{
+				if (m_edge == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex;
+			}
+			vertex_type target() const
+			{
+				if (m_edge == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_graph->m_slots[m_vertex].edges[m_edge].target;
+			}
+			template <bool W = Weighted, std::enable_if_t<W, int> = 0>
+			const weight_type& weight() const
+			{
+				if (m_edge == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_graph->m_slots[m_vertex].edges[m_edge].weight;
+			}
+
+			VertexIter getStartVertex() const
+			{
+				if (m_edge == npos)
+					throw std::runtime_error("Invalid iterator");
+				return VertexIter(m_graph, m_vertex);
+			}
+			VertexIter getEndVertex() const { return VertexIter(m_graph, target()); }
+
+			friend class DenseGraph;
+		private:
+			constexpr EdgeIter(const DenseGraph* graph, size_type vertex, size_type edge) noexcept
+				:m_graph(graph),
+				m_vertex(edge == npos ? npos : vertex),
+				m_edge(edge)
+			{}
+
+			const DenseGraph* m_graph;
+			size_type m_vertex;
+			size_type m_edge;
+		};
+
+		class VertexIter
+		{
+		public:
+			~VertexIter()								= default;
+			VertexIter(const VertexIter&)				= default;
+			VertexIter& operator=(const VertexIter&)	= default;
+
+			friend constexpr bool operator==(const VertexIter& lhs, const VertexIter& rhs) noexcept { return lhs.m_vertex == rhs.m_vertex; }
+			friend constexpr bool operator!=(const VertexIter& lhs, const VertexIter& rhs) noexcept { return !(lhs == rhs); }
+			VertexIter& operator++()
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("End of iteration reached");
+				if (++m_vertex == m_graph->size())
+					m_vertex = npos;
+				return *this;
+			}
+			vertex_type operator*() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex;
+			}
+
+			EdgeIter getEdges() const
+			{
+				if (m_vertex == npos)
+					throw std::runtime_error("Invalid iterator");
+				return EdgeIter(m_graph, m_vertex, m_graph->m_slots[m_vertex].edges.empty() ? npos : 0);
+			}
+
+			constexpr size_type getId() const noexcept { return m_vertex; }
+
+			friend class DenseGraph;
+		private:
+			constexpr VertexIter(const DenseGraph* graph, size_type vertex) noexcept
+				:m_graph(graph),
+				m_vertex(vertex)
+				{}
+
+			const DenseGraph* m_graph;
+			size_type m_vertex;
+		};
+
+		//	------------------------------------------ Defining Iter type traits
+
+	public:
+		using vertex_iterator				= VertexIter;
+		using edge_iterator					= EdgeIter;
+
+	// ------------------------------------------- DENSE GRAPH MAIN LOGIC -------------------------------------------
+	public:
+		DenseGraph()						= default;
+		explicit DenseGraph(size_type vertex_count)
+		{
+			m_slots.reserve(vertex_count);
+			resize(vertex_count);
+		}
+		DenseGraph(std::initializer_list<edge_type> list)
+		{
+			for (auto i = list.begin(); i != list.end(); ++i)
+				addEdge(*i);
+		}
+
+		// Appends a vertex and returns its id
+		size_type addVertex()
+		{
+			m_slots.emplace_back(edge_slot_allocator_type(m_slots.get_allocator()));
+			return m_slots.size() - 1;
+		}
+
+		// Grows the graph to at least vertex_count vertices
+		void resize(size_type vertex_count)
+		{
+			if (vertex_count <= m_slots.size())
+				return;
+			edge_slot_allocator_type allocator(m_slots.get_allocator());
+			while (m_slots.size() < vertex_count)
+				m_slots.emplace_back(allocator);
+		}
+
+		void reserve(size_type vertex_count) { m_slots.reserve(vertex_count); }
+
+		std::tuple<edge_iterator, bool> addEdge(const edge_type& edge)
+		{
+			auto from = std::get<0>(edge);
+			auto to = std::get<1>(edge);
+			// npos is no id, one past it would wrap to 0
+			if (from == npos || to == npos)
+				throw std::out_of_range("Vertex id out of range");
+			resize((from > to ? from : to) + 1);
+
+			if constexpr (!Directed)
+				addEdgeHelper(to, from, edgeWeight(edge));
+			return addEdgeHelper(from, to, edgeWeight(edge));
+		}
+
+		void addEdge(std::initializer_list<edge_type> list)
+		{
+			for (auto i = list.begin(); i != list.end(); ++i)
+				addEdge(*i);
+		}
+
+		template <class InputIt>
+		void addEdges(InputIt first, InputIt last)
+		{
+			for (; first != last; ++first)
+				addEdge(*first);
+		}
+
+		// O(1) with the edge index, the last edge of the vertex takes the place of the removed one
+		bool removeEdge(const edge_type& edge)
+		{
+			auto from = std::get<0>(edge);
+			auto to = std::get<1>(edge);
+			if (!removeEdgeHelper(from, to))
+				return false;
+			if constexpr (!Directed)
+			{
+				if (from != to)
+					removeEdgeHelper(to, from);
+			}
+			return true;
+		}
+
+		vertex_iterator findVertex(vertex_type vertex) const noexcept { return vertex < size() ? vertex_iterator(this, vertex) : end(); }
+
+		edge_iterator findEdge(const edge_type& edge) const noexcept
+		{
+			auto from = std::get<0>(edge);
+			auto to = std::get<1>(edge);
+			if (from >= size() || to >= size())
+				return edge_end();
+			return edge_iterator(this, from, findEdgeHelper(from, to));
+		}
+
+		vertex_iterator begin() const noexcept { return vertex_iterator(this, empty() ? npos : 0); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr, npos); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, npos, npos); }
+
+		vertex_iterator vertexAt(size_type id) const
+		{
+			if (id >= size())
+				throw std::out_of_range("Vertex id out of range");
+			return vertex_iterator(this, id);
+		}
+
+		size_type size() const noexcept { return m_slots.size(); }
+		bool empty() const noexcept { return m_slots.empty(); }
+		// Counts both directions of undirected edges, like CsrGraph
+		size_type edgeCount() const noexcept { return m_edge_count; }
+		size_type degree(size_type id) const noexcept { return m_slots[id].edges.size(); }
+
+		friend void swap(DenseGraph& lhs, DenseGraph& rhs) noexcept
+		{
+			// Enable ADL
+			using std::swap;
+			swap(lhs.m_slots, rhs.m_slots);
+			swap(lhs.m_edge_count, rhs.m_edge_count);
+		}
+
+		// Takes a CSR snapshot, the ids stay the same
+		friend CsrGraph<vertex_type, Directed, Weighted, allocator_type, weight_type> freeze(const DenseGraph& g)
+		{
+			using csr_type = CsrGraph<vertex_type, Directed, Weighted, allocator_type, weight_type>;
+			std::vector<vertex_type, allocator_type> vertices(g.size());
+			std::vector<size_type, typename csr_type::index_allocator_type> offsets;
+			std::vector<size_type, typename csr_type::index_allocator_type> neighbors;
+			std::vector<weight_type, typename csr_type::weight_allocator_type> weights;
+			offsets.reserve(g.size() + 1);
+			offsets.push_back(0);
+			neighbors.reserve(g.m_edge_count);
+			if constexpr (Weighted)
+				weights.reserve(g.m_edge_count);
+
+			for (size_type vertex = 0; vertex < g.size(); ++vertex)
+			{
+				vertices[vertex] = vertex;
+				for (const auto& edge : g.m_slots[vertex].edges)
+				{
+					neighbors.push_back(edge.target);
+					if constexpr (Weighted)
+						weights.push_back(edge.weight);
+				}
+				offsets.push_back(neighbors.size());
+			}
+			return csr_type(std::move(vertices), std::move(offsets), std::move(neighbors), std::move(weights));
+		}
+	private:
+		std::vector<VertexSlot, vertex_slot_allocator_type> m_slots;
+		size_type m_edge_count				= 0;
+
+		// Edge Helpers ----------------
+
+		std::tuple<edge_iterator, bool> addEdgeHelper(size_type from, size_type to, weight_type weight)
+		{
+			auto position = findEdgeHelper(from, to);
+			if (position != npos)
+				return std::make_tuple(edge_iterator(this, from, position), false);
+
+			auto& slot = m_slots[from];
+			position = slot.edges.size();
+			slot.edges.emplace_back(to, weight);
+			try
+			{
+				if (slot.edge_index != nullptr)
+					slot.edge_index->emplace(to, position);
+				else if (slot.edges.size() >= edge_index_threshold)
+					buildEdgeIndex(slot);
+			}
+			catch (...)
+			{
+				slot.edges.pop_back();
+				throw;
+			}
+			++m_edge_count;
+			return std::make_tuple(edge_iterator(this, from, position), true);
+		}
+
+		bool removeEdgeHelper(size_type from, size_type to)
+		{
+			auto position = from < size() && to < size() ? findEdgeHelper(from, to) : npos;
+			if (position == npos)
+				return false;
+
+			auto& slot = m_slots[from];
+			auto last = slot.edges.size() - 1;
+			if (slot.edge_index != nullptr)
+			{
+				slot.edge_index->erase(to);
+				if (position != last)
+					slot.edge_index->find(slot.edges[last].target)->second = position;
+			}
+			if (position != last)
+				slot.edges[position] = std::move(slot.edges[last]);
+			slot.edges.pop_back();
+			--m_edge_count;
+			// The index is dropped again once the degree halves
+			if (slot.edge_index != nullptr && slot.edges.size() < edge_index_threshold / 2)
+				slot.edge_index.reset();
+			return true;
+		}
+
+		// Returns the position of the edge in the edge array of from or npos if there is no such edge
+		size_type findEdgeHelper(size_type from, size_type to) const
+		{
+			const auto& slot = m_slots[from];
+			if (slot.edge_index != nullptr)
+			{
+				auto search = slot.edge_index->find(to);
+				return search == slot.edge_index->end() ? npos : search->second;
+			}
+
+			for (size_type position = 0; position < slot.edges.size(); ++position)
+				if (slot.edges[position].target == to)
+					return position;
+			return npos;
+		}
+
+		void buildEdgeIndex(VertexSlot& slot)
+		{
+			auto index = std::make_unique<EdgeIndex>(edge_index_allocator_type(m_slots.get_allocator()));
+			index->reserve(2 * slot.edges.size());
+			for (size_type position = 0; position < slot.edges.size(); ++position)
+				index->emplace(slot.edges[position].target, position);
+			slot.edge_index = std::move(index);
+		}
+
+		static constexpr weight_type edgeWeight(const edge_type& edge)
+		{
+			if constexpr (Weighted)
+				return std::get<2>(edge);
+			else
+				return weight_type(0);
+		}
+
+		// ---------------- Edge Helpers
+	};
+
+}	// namespace jvn
@@ -1,366 +1,1889 @@
-#pragma once
-// For std::...
-#include <functional>
-#include <stdexcept>
-#include <unordered_map>
-
-namespace jvn
-{
-
-	template <class V, bool Directed = false, bool Weighted = false,
-		class VerEq = std::equal_to<V>, class Alloc = std::allocator<V>>
-		class Graph
-	{
-	public:
-		using vertex_type					= V;
-		using edge_type						= std::conditional_t<Weighted,
-											std::tuple<vertex_type, vertex_type, int>,
-											std::tuple<vertex_type, vertex_type>>;
-		using size_type						= size_t;
-		using vertex_equal					= VerEq;
-		using allocator_type				= Alloc;
-	private:
-		//	Defining Node type traits ------------------------------------------
-
-		//	Forward declare VertexNode
-		struct VertexNode;
-
-		template <bool W>
-		struct EdgeNodeConditional
-		{
-			EdgeNodeConditional(VertexNode* v)
-				:vertex_node(v)
-				{}
-			int weight						= 0;
-			VertexNode* vertex_node			= nullptr;
-			EdgeNodeConditional* next		= nullptr;
-		};
-
-		template <>
-		struct EdgeNodeConditional<false>
-		{
-			EdgeNodeConditional(VertexNode* v)
-				:vertex_node(v)
-				{}
-			VertexNode* vertex_node			= nullptr;
-			EdgeNodeConditional* next		= nullptr;
-		};
-
-		using EdgeNode = EdgeNodeConditional<Weighted>;
-
-		struct VertexNode
-		{
-			VertexNode(const vertex_type& v)
-				:vertex(v) 
-				{}
-			VertexNode(vertex_type&& v)
-				:vertex(std::move(v)) 
-				{}
-			vertex_type vertex;
-			EdgeNode* edge_list				= nullptr;
-			VertexNode* next				= nullptr;
-		};
-
-		using vertex_node_allocator_type	= typename allocator_type::template rebind<VertexNode>::other;
-		using edge_node_allocator_type		= typename allocator_type::template rebind<EdgeNode>::other;
-
-		//	------------------------------------------ Defining Node type traits
-	private:
-		//	Defining Iter type traits ------------------------------------------
-
-		// Forward declare VertexIter
-		class VertexIter;
-
-		class EdgeIter
-		{
-		public:
-			~EdgeIter()								= default;
-			EdgeIter(const EdgeIter&)				= default;
-			EdgeIter& operator=(const EdgeIter&)	= default;
-
-			friend constexpr bool operator==(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return lhs.m_edge_node == rhs.m_edge_node; }
-			friend constexpr bool operator!=(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return !(lhs == rhs); }
-			EdgeIter& operator++()
-			{
-				if (m_edge_node == nullptr)
-					throw std::runtime_error("End of iteration reached");
-				m_edge_node = m_edge_node->next;
-				return *this;
-			}
-			edge_type operator*()
-			{
-				if (m_edge_node == nullptr)
-					throw std::runtime_error("Invalid iterator");
-				return getTuple<Weighted>();
-			}
-
-			constexpr VertexIter getStartVertex() const noexcept { return VertexIter(m_vertex_node); }
-
-			friend class Graph;
-		private:
-			EdgeIter(VertexNode* vertex_node, EdgeNode* edge_node) noexcept
-				:m_vertex_node(vertex_node),
-				m_edge_node(edge_node)
-			{}
-
-			// Two templates for weighted and non-weighted
-			template <bool W>
-			constexpr edge_type getTuple() { return std::make_tuple(m_vertex_node->vertex, m_edge_node->vertex_node->vertex, m_edge_node->weight); }
-			template <>
-			constexpr edge_type getTuple<false>() { return std::make_tuple(m_vertex_node->vertex, m_edge_node->vertex_node->vertex); }
-
-			VertexNode* m_vertex_node;
-			EdgeNode* m_edge_node;
-		};
-
-		class VertexIter
-		{
-		public:
-			~VertexIter()								= default;
-			VertexIter(const VertexIter&)				= default;
-			VertexIter& operator=(const VertexIter&)	= default;
-
-			friend constexpr bool operator==(const VertexIter& lhs, const VertexIter& rhs) noexcept { return lhs.m_vertex_node == rhs.m_vertex_node; }
-			friend constexpr bool operator!=(const VertexIter& lhs, const VertexIter& rhs) noexcept { return !(lhs == rhs); }
-			VertexIter& operator++()
-			{
-				if (m_vertex_node == nullptr)
-					throw std::runtime_error("End of iteration reached");
-				m_vertex_node = m_vertex_node->next;
-				return *this;
-			}
-			vertex_type* operator->() 
-			{
-				if (m_vertex_node == nullptr)
-					throw std::runtime_error("Invalid iterator");
-				return &(m_vertex_node->vertex); 
-			}
-			vertex_type& operator*() 
-			{ 
-				if (m_vertex_node == nullptr)
-					throw std::runtime_error("Invalid iterator");
-				return m_vertex_node->vertex; 
-			}
-
-			EdgeIter getEdges() noexcept { return EdgeIter(m_vertex_node, m_vertex_node->edge_list); }
-
-			friend class Graph;
-		private:
-			VertexIter(VertexNode* vertex_node) noexcept
-				:m_vertex_node(vertex_node)
-				{}
-
-			VertexNode* m_vertex_node;
-		};
-
-		//	------------------------------------------ Defining Node type traits
-
-	public:
-		using vertex_iterator				= VertexIter;
-		using edge_iterator					= EdgeIter;
-
-	// ------------------------------------------- GRAPH MAIN LOGIC -------------------------------------------
-	public:
-		Graph() 
-			:m_vertex_node_list(nullptr),
-			m_size(0)
-			{};
-		Graph(std::initializer_list<edge_type> list): Graph()
-		{
-			for (auto i = list.begin(); i != list.end(); ++i)
-				addEdge(*i);
-		}
-		Graph(const Graph& g) : Graph() { operator=(g); }
-		Graph(Graph&& g) : Graph() { swap(g, *this); }
-		Graph& operator=(const Graph& g)
-		{
-			destroyGraph();
-			for (auto v = g.begin(); v != g.end(); ++v)
-				for (auto e = v.getEdges(); e != g.edge_end(); ++e)
-					addEdge(*e);
-			return *this;
-		}
-		Graph& operator=(Graph&& g) { swap(g, *this); return *this; }
-		~Graph() { destroyGraph(); }
-
-		template <class Ty, std::enable_if_t<std::is_same<std::decay_t<Ty>, vertex_type>::value, int> = 0>
-		std::tuple<vertex_iterator, bool> addVertex(Ty&& vertex)
-		{
-			if (m_vertex_node_list == nullptr)
-			{
-				m_vertex_node_list = m_vertex_node_allocator.allocate(1);
-				m_vertex_node_allocator.construct(m_vertex_node_list, std::forward<Ty>(vertex));
-				++m_size;
-				return std::make_tuple(vertex_iterator(m_vertex_node_list), true);
-			}
-
-			auto search = findVertexHelper(vertex);
-
-			if (vertex_equal{}(search->vertex, vertex))
-				return std::make_tuple(vertex_iterator(search), false);
-
-			search->next = m_vertex_node_allocator.allocate(1);
-			m_vertex_node_allocator.construct(search->next, std::forward<Ty>(vertex));
-			++m_size;
-			return std::make_tuple(vertex_iterator(search->next), true);
-		}
-
-		void addVertex(std::initializer_list<vertex_type> list)
-		{
-			for (auto i = list.begin(); i != list.end(); ++i)
-				addVertex(*i);
-		}
-
-		std::tuple<edge_iterator, bool> addEdge(const edge_type& edge)
-		{ return addEdgeCaller<Directed>(edge); }
-
-		void addEdge(std::initializer_list<edge_type> list)
-		{
-			for (auto i = list.begin(); i != list.end(); ++i)
-				addEdge(*i);
-		}
-
-		vertex_iterator findVertex(const vertex_type& vertex) const
-		{
-			auto search = findVertexHelper(vertex);
-			if (search == nullptr || !vertex_equal{}(search->vertex, vertex))
-				return end();
-			return vertex_iterator(search);
-		}
-
-		edge_iterator findEdge(const edge_type& edge) const
-		{
-			auto from = findVertex(std::get<0>(edge)).m_vertex_node;
-			auto to = findVertex(std::get<1>(edge)).m_vertex_node;
-
-			auto edge_search = findEdgeHelper(from, to);
-			if (edge_search != nullptr && edge_search->vertex_node != to)
-				return edge_end();
-			return edge_iterator(from, edge_search);
-		}
-
-		constexpr vertex_iterator begin() const noexcept { return vertex_iterator(m_vertex_node_list); }
-		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr); }
-		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, nullptr); }
-
-		friend void swap(const Graph& lhs, const Graph& rhs)
-		{
-			// Enable ADL
-			using std::swap;
-			swap(lhs.m_vertex_node_list, rhs.m_vertex_node_list);
-			swap(lhs.m_vertex_node_allocator, rhs.vertex_node_allocator);
-			swap(lhs.m_edge_node_allocator, rhs.m_edge_node_allocator);
-			swap(lhs.m_size, rhs.m_size);
-		}
-	private:
-		VertexNode* m_vertex_node_list;
-		vertex_node_allocator_type m_vertex_node_allocator;
-		edge_node_allocator_type m_edge_node_allocator;
-		size_type m_size;
-
-		// Edge Helpers ----------------
-
-		std::tuple<edge_iterator, bool> addEdgeHelper(VertexNode* from, VertexNode* to, int weight = 0)
-		{
-			if (from->edge_list == nullptr)
-			{
-				from->edge_list = m_edge_node_allocator.allocate(1);
-				m_edge_node_allocator.construct(from->edge_list, EdgeNode(to));
-				setEdgeWeight<Weighted>(from->edge_list, weight);
-				return std::make_tuple(edge_iterator(from, from->edge_list), true);
-			}
-
-			auto edge_search = findEdgeHelper(from, to);
-
-			if (edge_search->vertex_node == to)
-				return std::make_tuple(edge_iterator(from, edge_search), false);
-
-			edge_search->next = m_edge_node_allocator.allocate(1);
-			m_edge_node_allocator.construct(edge_search->next, EdgeNode(to));
-			setEdgeWeight<Weighted>(edge_search->next, weight);
-			return std::make_tuple(edge_iterator(from, edge_search->next), true);
-		}
-
-		// Specialized functions for directed and non-directed
-		template <bool W>
-		std::tuple<edge_iterator, bool> addEdgeCaller(const edge_type& edge)
-		{
-			auto vertex_from_node = std::get<0>(addVertex(std::get<0>(edge))).m_vertex_node;
-			auto vertex_to_node = std::get<0>(addVertex(std::get<1>(edge))).m_vertex_node;
-
-			addEdgeHelper(vertex_to_node, vertex_from_node,
-				std::intptr_t(std::get<std::tuple_size<edge_type>::value - 1>(edge)));
-			return addEdgeHelper(vertex_from_node, vertex_to_node,
-				std::intptr_t(std::get<std::tuple_size<edge_type>::value - 1>(edge))); 
-		}
-		template <>
-		std::tuple<edge_iterator, bool> addEdgeCaller<true>(const edge_type& edge)
-		{
-			auto vertex_from_node = std::get<0>(addVertex(std::get<0>(edge))).m_vertex_node;
-			auto vertex_to_node = std::get<0>(addVertex(std::get<1>(edge))).m_vertex_node;
-
-			return addEdgeHelper(vertex_from_node, vertex_to_node,
-				std::intptr_t(std::get<std::tuple_size<edge_type>::value - 1>(edge)));
-		}
-
-	
-		// Specialized functions for weighted and unweighted	
-		template <bool W>
-		constexpr void setEdgeWeight(EdgeNode* edge, int weight) const
-		{ edge->weight = weight; }
-		template <>
-		constexpr void setEdgeWeight<false>(EdgeNode* edge, int weight) const
-		{}
-
-		// Returns the edge with the vertex ot the last edge in the list or nullptr if the edge list is empty
-		EdgeNode* findEdgeHelper(VertexNode* from, VertexNode* to) const
-		{
-			if (from == nullptr || to == nullptr)
-				return nullptr;
-			
-			auto search = from->edge_list;
-			while (search != nullptr && search->next != nullptr && search->vertex_node != to)
-				search = search->next;
-			return search;
-		}
-
-		// ---------------- Edge Helpers
-
-		// Returns the node with the vertex or the last node in the list or nullptr if the list is empty
-		VertexNode* findVertexHelper(const vertex_type& vertex) const
-		{
-			if (m_vertex_node_list == nullptr)
-				return nullptr;
-
-			auto search = m_vertex_node_list;
-			while (search->next != nullptr && !vertex_equal{}(vertex, search->vertex))
-				search = search->next;
-			return search;
-		}
-
-		void destroyGraph()
-		{
-			auto search = m_vertex_node_list;
-			while (search != nullptr)
-			{
-				auto next = search->next;
-
-				// Deallocate edge list
-				auto edge_search = search->edge_list;
-				while (edge_search != nullptr)
-				{
-					auto edge_next = edge_search->next;
-					m_edge_node_allocator.deallocate(edge_search, 1);
-					edge_search = edge_next;
-				}
-
-				m_vertex_node_allocator.destroy(search);
-				m_vertex_node_allocator.deallocate(search, 1);
-				search = next;
-			}
-			m_size = 0;
-			m_vertex_node_list = nullptr;
-		}
-	};
-
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "GraphStats.h"
+#include "Heap.h"
+#include "UnionFind.h"
+
+namespace jvn
+{
+
+	// Resolves to std::hash<V> when V is hashable and to void otherwise
+	template <class V, class = void>
+	struct default_vertex_hash
+	{
+		using type = void;
+	};
+
+	template <class V>
+	struct default_vertex_hash<V, std::void_t<decltype(std::hash<V>{}(std::declval<const V&>()))>>
+	{
+		using type = std::hash<V>;
+	};
+
+	template <class V>
+	using default_vertex_hash_t = typename default_vertex_hash<V>::type;
+
+	// Detects allocators that can free everything they handed out at once, like PoolAllocator
+	template <class A, class = void>
+	struct is_releasable_allocator : std::false_type {};
+
+	template <class A>
+	struct is_releasable_allocator<A, std::void_t<decltype(std::declval<A&>().release())>> : std::true_type {};
+
+	// Detects allocators that can preallocate room for a number of objects, like PoolAllocator
+	template <class A, class = void>
+	struct is_reservable_allocator : std::false_type {};
+
+	template <class A>
+	struct is_reservable_allocator<A, std::void_t<decltype(std::declval<A&>().reserve(size_t(0)))>> : std::true_type {};
+
+	// Specialize with value = true to keep the vertices of a type out of the vertex nodes. They are then
+	// stored in a pool of their own and nodes only point at them, which makes nodes of heavy vertex types
+	// smaller and keeps the values out of the cache lines traversals touch. Iterators still hand out
+	// references to the vertices.
+	template <class V>
+	struct out_of_line_vertices : std::false_type {};
+
+	// Forward declare the frozen representation, see CsrGraph.h
+	template <class V, bool Directed, bool Weighted, class Alloc, class Weight>
+	class CsrGraph;
+
+	// Forward declare the compressed frozen representation, see CompressedGraph.h
+	template <class V, bool Directed, bool Weighted, class Alloc, class Weight>
+	class CompressedCsrGraph;
+
+	// Passing void as Hash disables the vertex hash index and falls back to a linear scan using VerEq.
+	// Weight is the arithmetic type of the edge weights, only used by weighted graphs.
+	// InEdges makes a directed graph also record every edge at its target, which gives the predecessors
+	// of a vertex, bidirectional search and vertex removal in O(in-degree) for an in-edge record and a
+	// position per edge.
+	// Stats is the policy the hot paths report to, see GraphStats.h, the default compiles to nothing.
+	template <class V, bool Directed = false, bool Weighted = false,
+		class VerEq = std::equal_to<V>, class Hash = default_vertex_hash_t<V>, class Alloc = std::allocator<V>, class Weight = int,
+		bool InEdges = false, class Stats = NoGraphStats>
+		class Graph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		// What edge iterators dereference to, refers to the values stored in the graph instead of copying them
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+		// Path lengths, edges of unweighted graphs count as 1. Integer weights are summed in 64 bits so
+		// narrow weights can't overflow, floating point ones in at least double precision.
+		using distance_type					= std::conditional_t<std::is_floating_point<weight_type>::value,
+											std::common_type_t<weight_type, double>,
+											std::int64_t>;
+		using vertex_equal					= VerEq;
+		using vertex_hash					= Hash;
+		using allocator_type				= Alloc;
+
+		static constexpr bool hashed		= !std::is_void<vertex_hash>::value;
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+		static constexpr bool in_edges		= InEdges;
+		static constexpr bool out_of_line	= out_of_line_vertices<V>::value;
+
+		static_assert(std::is_arithmetic<weight_type>::value, "Edge weights have to be arithmetic");
+		static_assert(Directed || !InEdges, "Undirected graphs reach their in-edges through the mirrored out-edges");
+	private:
+		// Allocator of the standard containers of the graph, counting policies see their allocations too
+		template <class T>
+		using container_allocator_type		= std::conditional_t<Stats::enabled,
+											StatsAllocator<typename allocator_type::template rebind<T>::other, Stats>,
+											typename allocator_type::template rebind<T>::other>;
+
+		//	Defining Node type traits ------------------------------------------
+
+		//	Forward declare VertexNode
+		struct VertexNode;
+
+		// Position of the edge in the in-edges of its target, only kept with InEdges
+		template <bool I, class Dummy = void>
+		struct InPositionConditional
+		{
+			size_type in_position;
+		};
+
+		template <class Dummy>
+		struct InPositionConditional<false, Dummy> {};
+
+		// Edges are compact records in one array per vertex and walked by index, see EdgeArray
+		template <bool W, class Dummy = void>
+		struct EdgeConditional : InPositionConditional<InEdges>
+		{
+			VertexNode* vertex_node;
+			weight_type weight;
+		};
+
+		// Partial rather than explicit specialization, which isn't allowed at class scope
+		template <class Dummy>
+		struct EdgeConditional<false, Dummy> : InPositionConditional<InEdges>
+		{
+			VertexNode* vertex_node;
+		};
+
+		using Edge = EdgeConditional<Weighted>;
+
+		// An edge pointing at a vertex of an InEdges graph, found at position in the edges of its source
+		struct InEdge
+		{
+			VertexNode* source;
+			size_type position;
+		};
+
+		// Records stored in the vertex node itself, enough for most vertices of power law graphs
+		static constexpr size_type inline_edge_capacity = 4;
+
+		// Small vector of the edge records of a vertex. The first inline_edge_capacity records live in the
+		// node, once they outgrow it all of them move to a buffer that doubles. Positions never change on
+		// growth, removal moves the last record into the freed position.
+		template <class T>
+		struct EdgeArray
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Edge records are moved with plain copies");
+
+			T* data() noexcept { return capacity == inline_edge_capacity ? inline_records : records; }
+			const T* data() const noexcept { return capacity == inline_edge_capacity ? inline_records : records; }
+			T* begin() noexcept { return data(); }
+			T* end() noexcept { return data() + size; }
+			const T* begin() const noexcept { return data(); }
+			const T* end() const noexcept { return data() + size; }
+
+			union
+			{
+				T inline_records[inline_edge_capacity];
+				T* records;
+			};
+			size_type size					= 0;
+			size_type capacity				= inline_edge_capacity;
+		};
+
+		template <bool I, class Dummy = void>
+		struct InEdgeListConditional
+		{
+			EdgeArray<InEdge> in_edges;
+		};
+
+		template <class Dummy>
+		struct InEdgeListConditional<false, Dummy> {};
+
+		// Maps a target vertex to the position of the edge pointing at it, built once the degree passes
+		// edge_index_threshold
+		using edge_index_allocator_type		= container_allocator_type<std::pair<VertexNode* const, size_type>>;
+		using EdgeIndex						= std::unordered_map<VertexNode*, size_type, std::hash<VertexNode*>,
+											std::equal_to<VertexNode*>, edge_index_allocator_type>;
+
+		// Capacity of the buffer the edges of a vertex move to from the node unless reserve expects a
+		// higher degree, later ones double it
+		static constexpr size_type first_edge_buffer_capacity = 2 * inline_edge_capacity;
+
+		// Out of line vertices are held in slots of doubling chunks that never move, so nodes and index keys
+		// can point at them. Freed slots are reused before fresh ones.
+		class VertexPool
+		{
+		public:
+			VertexPool()								= default;
+			VertexPool(const VertexPool&)				= delete;
+			VertexPool& operator=(const VertexPool&)	= delete;
+			~VertexPool() { release(); }
+
+			template <class Ty>
+			vertex_type* create(Ty&& vertex)
+			{
+				Slot* slot = m_free;
+				if (slot != nullptr)
+					m_free = slot->next;
+				else
+				{
+					if (m_fresh == m_fresh_end)
+						allocateChunk(m_chunks == nullptr ? first_chunk_capacity : 2 * m_chunks->capacity);
+					slot = m_fresh++;
+				}
+				try
+				{
+					m_allocator.construct(reinterpret_cast<vertex_type*>(slot->storage), std::forward<Ty>(vertex));
+				}
+				catch (...)
+				{
+					slot->next = m_free;
+					m_free = slot;
+					throw;
+				}
+				return reinterpret_cast<vertex_type*>(slot->storage);
+			}
+
+			void destroy(vertex_type* vertex) noexcept
+			{
+				m_allocator.destroy(vertex);
+				auto slot = reinterpret_cast<Slot*>(vertex);
+				slot->next = m_free;
+				m_free = slot;
+			}
+
+			// Makes sure the next count vertices don't need a new chunk
+			void reserve(size_type count)
+			{
+				if (size_type(m_fresh_end - m_fresh) < count)
+					allocateChunk(count);
+			}
+
+			// Frees the chunks, every vertex has to be destroyed already
+			void release() noexcept
+			{
+				chunk_allocator_type chunk_allocator(m_slot_allocator);
+				while (m_chunks != nullptr)
+				{
+					auto chunk = m_chunks;
+					m_chunks = chunk->next;
+					m_slot_allocator.deallocate(chunk->slots, chunk->capacity);
+					chunk_allocator.deallocate(chunk, 1);
+				}
+				m_free = m_fresh = m_fresh_end = nullptr;
+			}
+
+			friend void swap(VertexPool& lhs, VertexPool& rhs) noexcept
+			{
+				// Enable ADL
+				using std::swap;
+				swap(lhs.m_allocator, rhs.m_allocator);
+				swap(lhs.m_slot_allocator, rhs.m_slot_allocator);
+				swap(lhs.m_chunks, rhs.m_chunks);
+				swap(lhs.m_free, rhs.m_free);
+				swap(lhs.m_fresh, rhs.m_fresh);
+				swap(lhs.m_fresh_end, rhs.m_fresh_end);
+			}
+		private:
+			union Slot
+			{
+				Slot* next;
+				alignas(vertex_type) unsigned char storage[sizeof(vertex_type)];
+			};
+
+			struct Chunk
+			{
+				Chunk* next;
+				Slot* slots;
+				size_type capacity;
+			};
+
+			using slot_allocator_type		= typename allocator_type::template rebind<Slot>::other;
+			using chunk_allocator_type		= typename allocator_type::template rebind<Chunk>::other;
+
+			static constexpr size_type first_chunk_capacity = 16;
+
+			void allocateChunk(size_type capacity)
+			{
+				chunk_allocator_type chunk_allocator(m_slot_allocator);
+				auto chunk = chunk_allocator.allocate(1);
+				try
+				{
+					chunk_allocator.construct(chunk, Chunk{ m_chunks, m_slot_allocator.allocate(capacity), capacity });
+				}
+				catch (...)
+				{
+					chunk_allocator.deallocate(chunk, 1);
+					throw;
+				}
+				Stats::allocation(sizeof(Chunk) + capacity * sizeof(Slot));
+				m_chunks = chunk;
+				m_fresh = chunk->slots;
+				m_fresh_end = chunk->slots + capacity;
+			}
+
+			allocator_type m_allocator;
+			slot_allocator_type m_slot_allocator;
+			Chunk* m_chunks					= nullptr;
+			Slot* m_free					= nullptr;
+			Slot* m_fresh					= nullptr;
+			Slot* m_fresh_end				= nullptr;
+		};
+
+		struct NoVertexPool {};
+
+		using vertex_pool_type				= std::conditional_t<out_of_line, VertexPool, NoVertexPool>;
+		using vertex_storage_type			= std::conditional_t<out_of_line, vertex_type*, vertex_type>;
+
+		struct VertexNode : InEdgeListConditional<InEdges>
+		{
+			// The vertex itself, or a pointer to it in the vertex pool for out of line vertices
+			template <class Ty>
+			explicit VertexNode(Ty&& v)
+				:stored_vertex(std::forward<Ty>(v)) 
+				{}
+
+			vertex_type& vertex() noexcept
+			{
+				if constexpr (out_of_line)
+					return *stored_vertex;
+				else
+					return stored_vertex;
+			}
+			const vertex_type& vertex() const noexcept
+			{
+				if constexpr (out_of_line)
+					return *stored_vertex;
+				else
+					return stored_vertex;
+			}
+
+			vertex_storage_type stored_vertex;
+			EdgeArray<Edge> edges;
+			EdgeIndex* edge_index			= nullptr;
+			// Number of edges pointing at the vertex, lets removal skip the search for incoming edges
+			size_type in_degree				= 0;
+			// Dense id in [0, size), removing a vertex hands its id to the vertex with the highest id
+			size_type id					= 0;
+			VertexNode* prev				= nullptr;
+			VertexNode* next				= nullptr;
+		};
+
+		using vertex_node_allocator_type	= typename allocator_type::template rebind<VertexNode>::other;
+		using edge_allocator_type			= typename allocator_type::template rebind<Edge>::other;
+		using in_edge_allocator_type		= typename allocator_type::template rebind<InEdge>::other;
+		using edge_index_node_allocator_type = typename allocator_type::template rebind<EdgeIndex>::other;
+		using vertex_table_allocator_type	= container_allocator_type<VertexNode*>;
+
+		// Below this degree edge lookups scan the (short) edge records, above it they go through the edge index
+		static constexpr size_type edge_index_threshold = 16;
+
+		//	------------------------------------------ Defining Node type traits
+	private:
+		//	Defining Index type traits -----------------------------------------
+
+		// The index is keyed by a reference to the vertex stored in its node so values aren't duplicated.
+		// Nodes are never relocated, which keeps the keys valid for the lifetime of the node.
+		using vertex_key					= std::reference_wrapper<const vertex_type>;
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const vertex_key& key) const { return vertex_hash{}(key.get()); }
+		};
+
+		struct VertexKeyEqual
+		{
+			bool operator()(const vertex_key& lhs, const vertex_key& rhs) const { return vertex_equal{}(lhs.get(), rhs.get()); }
+		};
+
+		struct NoVertexIndex {};
+
+		using vertex_index_allocator_type	= container_allocator_type<std::pair<const vertex_key, VertexNode*>>;
+		using vertex_index_type				= std::conditional_t<hashed,
+											std::unordered_map<vertex_key, VertexNode*, VertexKeyHash, VertexKeyEqual, vertex_index_allocator_type>,
+											NoVertexIndex>;
+
+		//	----------------------------------------- Defining Index type traits
+	private:
+		//	Defining Iter type traits ------------------------------------------
+
+		// Forward declare VertexIter
+		class VertexIter;
+
+		class EdgeIter
+		{
+		public:
+			~EdgeIter()								= default;
+			EdgeIter(const EdgeIter&)				= default;
+			EdgeIter& operator=(const EdgeIter&)	= default;
+
+			friend constexpr bool operator==(const EdgeIter& lhs, const EdgeIter& rhs) noexcept
+			{
+				return lhs.m_vertex_node == rhs.m_vertex_node && lhs.m_position == rhs.m_position;
+			}
+			friend constexpr bool operator!=(const EdgeIter& lhs, const EdgeIter& rhs) noexcept { return !(lhs == rhs); }
+			EdgeIter& operator++()
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("End of iteration reached");
+				if (++m_position == m_vertex_node->edges.size)
+					*this = EdgeIter(nullptr, 0);
+				return *this;
+			}
+			// Converts to edge_type when a copy is needed
+			edge_reference operator*() const
+			{
+				const auto& edge = record();
+				Stats::dereference();
+				if constexpr (Weighted)
+					return edge_reference(m_vertex_node->vertex(), edge.vertex_node->vertex(), edge.weight);
+				else
+					return edge_reference(m_vertex_node->vertex(), edge.vertex_node->vertex());
+			}
+
+			const vertex_type& source() const
+			{
+				record();
+				return m_vertex_node->vertex();
+			}
+			const vertex_type& target() const { return record().vertex_node->vertex(); }
+			template <bool W = Weighted, std::enable_if_t<W, int> = 0>
+			const weight_type& weight() const { return record().weight; }
+
+			constexpr VertexIter getStartVertex() const noexcept { return VertexIter(m_vertex_node); }
+			VertexIter getEndVertex() const { return VertexIter(record().vertex_node); }
+
+			friend class Graph;
+		private:
+			EdgeIter(VertexNode* vertex_node, size_type position) noexcept
+				:m_vertex_node(vertex_node),
+				m_position(position)
+			{}
+
+			const Edge& record() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->edges.data()[m_position];
+			}
+
+			// The end iterator has no vertex node
+			VertexNode* m_vertex_node;
+			size_type m_position;
+		};
+
+		// Walks the edges pointing at a vertex of an InEdges graph, the same edges the edge iterators of
+		// their source vertices reach
+		class InEdgeIter
+		{
+		public:
+			~InEdgeIter()								= default;
+			InEdgeIter(const InEdgeIter&)				= default;
+			InEdgeIter& operator=(const InEdgeIter&)	= default;
+
+			friend constexpr bool operator==(const InEdgeIter& lhs, const InEdgeIter& rhs) noexcept
+			{
+				return lhs.m_vertex_node == rhs.m_vertex_node && lhs.m_position == rhs.m_position;
+			}
+			friend constexpr bool operator!=(const InEdgeIter& lhs, const InEdgeIter& rhs) noexcept { return !(lhs == rhs); }
+			InEdgeIter& operator++()
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("End of iteration reached");
+				if (++m_position == m_vertex_node->in_edges.size)
+					*this = InEdgeIter(nullptr, 0);
+				return *this;
+			}
+			edge_reference operator*() const
+			{
+				const auto& in_edge = record();
+				Stats::dereference();
+				if constexpr (Weighted)
+					return edge_reference(in_edge.source->vertex(), m_vertex_node->vertex(),
+						in_edge.source->edges.data()[in_edge.position].weight);
+				else
+					return edge_reference(in_edge.source->vertex(), m_vertex_node->vertex());
+			}
+
+			const vertex_type& source() const { return record().source->vertex(); }
+			const vertex_type& target() const
+			{
+				record();
+				return m_vertex_node->vertex();
+			}
+			template <bool W = Weighted, std::enable_if_t<W, int> = 0>
+			const weight_type& weight() const
+			{
+				const auto& in_edge = record();
+				return in_edge.source->edges.data()[in_edge.position].weight;
+			}
+
+			// The predecessor
+			VertexIter getStartVertex() const { return VertexIter(record().source); }
+			constexpr VertexIter getEndVertex() const noexcept { return VertexIter(m_vertex_node); }
+			// The same edge as seen from its source, e.g. for removeEdge
+			EdgeIter getEdge() const
+			{
+				const auto& in_edge = record();
+				return EdgeIter(in_edge.source, in_edge.position);
+			}
+
+			friend class Graph;
+		private:
+			InEdgeIter(VertexNode* vertex_node, size_type position) noexcept
+				:m_vertex_node(vertex_node),
+				m_position(position)
+			{}
+
+			const InEdge& record() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->in_edges.data()[m_position];
+			}
+
+			// The end iterator has no vertex node
+			VertexNode* m_vertex_node;
+			size_type m_position;
+		};
+
+		class VertexIter
+		{
+		public:
+			~VertexIter()								= default;
+			VertexIter(const VertexIter&)				= default;
+			VertexIter& operator=(const VertexIter&)	= default;
+
+			friend constexpr bool operator==(const VertexIter& lhs, const VertexIter& rhs) noexcept { return lhs.m_vertex_node == rhs.m_vertex_node; }
+			friend constexpr bool operator!=(const VertexIter& lhs, const VertexIter& rhs) noexcept { return !(lhs == rhs); }
+			VertexIter& operator++()
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("End of iteration reached");
+				m_vertex_node = m_vertex_node->next;
+				return *this;
+			}
+			vertex_type* operator->() 
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				Stats::dereference();
+				return &(m_vertex_node->vertex()); 
+			}
+			vertex_type& operator*() 
+			{ 
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				Stats::dereference();
+				return m_vertex_node->vertex(); 
+			}
+
+			EdgeIter getEdges() noexcept
+			{
+				return m_vertex_node->edges.size == 0 ? EdgeIter(nullptr, 0) : EdgeIter(m_vertex_node, 0);
+			}
+			template <bool I = InEdges, std::enable_if_t<I, int> = 0>
+			InEdgeIter getInEdges() noexcept
+			{
+				return m_vertex_node->in_edges.size == 0 ? InEdgeIter(nullptr, 0) : InEdgeIter(m_vertex_node, 0);
+			}
+
+			size_type getId() const
+			{
+				if (m_vertex_node == nullptr)
+					throw std::runtime_error("Invalid iterator");
+				return m_vertex_node->id;
+			}
+
+			friend class Graph;
+		private:
+			VertexIter(VertexNode* vertex_node) noexcept
+				:m_vertex_node(vertex_node)
+				{}
+
+			VertexNode* m_vertex_node;
+		};
+
+		//	------------------------------------------ Defining Node type traits
+	private:
+		//	Defining Traversal type traits -------------------------------------
+
+		// Scratch state for bfs and dfs. Visitation marks are epoch stamps indexed by dense vertex id so
+		// starting a traversal doesn't clear anything, reusing a workspace makes traversals allocation free.
+		class TraversalWorkspace
+		{
+		public:
+			TraversalWorkspace()											= default;
+			TraversalWorkspace(const TraversalWorkspace&)					= default;
+			TraversalWorkspace& operator=(const TraversalWorkspace&)		= default;
+
+			friend class Graph;
+		private:
+			void start(size_type size)
+			{
+				if (m_marks.size() < size)
+					m_marks.resize(size, 0);
+				if (++m_epoch == 0)
+				{
+					std::fill(m_marks.begin(), m_marks.end(), 0);
+					m_epoch = 1;
+				}
+				m_queue.clear();
+				m_stack.clear();
+			}
+
+			bool visit(const VertexNode* node) noexcept
+			{
+				if (m_marks[node->id] == m_epoch)
+					return false;
+				m_marks[node->id] = m_epoch;
+				return true;
+			}
+
+			std::vector<std::uint32_t> m_marks;
+			std::uint32_t m_epoch = 0;
+			std::vector<VertexNode*> m_queue;
+			std::vector<std::pair<VertexNode*, size_type>> m_stack;
+		};
+
+		// Search state of one direction of a shortest path query, distances are epoch stamped like the
+		// traversal marks so a reused workspace answers point to point queries without an O(V) reset
+		template <template <class, class> class Heap>
+		class ShortestPathSearch
+		{
+		public:
+			friend class Graph;
+		private:
+			void start(size_type size)
+			{
+				if (m_stamps.size() < size)
+				{
+					m_stamps.resize(size, 0);
+					m_distances.resize(size);
+					m_predecessors.resize(size);
+				}
+				if (++m_epoch == 0)
+				{
+					std::fill(m_stamps.begin(), m_stamps.end(), 0);
+					m_epoch = 1;
+				}
+				m_heap.clear();
+			}
+
+			distance_type distance(const VertexNode* node) const noexcept
+			{ return m_stamps[node->id] == m_epoch ? m_distances[node->id] : unreachable; }
+
+			VertexNode* predecessor(const VertexNode* node) const noexcept
+			{ return m_stamps[node->id] == m_epoch ? m_predecessors[node->id] : nullptr; }
+
+			// Returns true if the distance improved
+			bool relax(VertexNode* node, distance_type distance, VertexNode* predecessor)
+			{
+				if (distance >= this->distance(node))
+					return false;
+				m_stamps[node->id] = m_epoch;
+				m_distances[node->id] = distance;
+				m_predecessors[node->id] = predecessor;
+				m_heap.push(distance, node);
+				return true;
+			}
+
+			std::vector<std::uint32_t> m_stamps;
+			std::vector<distance_type> m_distances;
+			std::vector<VertexNode*> m_predecessors;
+			std::uint32_t m_epoch = 0;
+			Heap<distance_type, VertexNode*> m_heap;
+		};
+
+		// Scratch state for the shortest path queries, reusing one keeps queries allocation free.
+		// The backward search is only sized once a bidirectional query runs.
+		template <template <class, class> class Heap>
+		class ShortestPathWorkspace
+		{
+		public:
+			ShortestPathWorkspace()											= default;
+			ShortestPathWorkspace(const ShortestPathWorkspace&)				= default;
+			ShortestPathWorkspace& operator=(const ShortestPathWorkspace&)	= default;
+
+			friend class Graph;
+		private:
+			ShortestPathSearch<Heap> m_forward;
+			ShortestPathSearch<Heap> m_backward;
+		};
+
+		//	------------------------------------- Defining Traversal type traits
+
+	public:
+		using vertex_iterator				= VertexIter;
+		using edge_iterator					= EdgeIter;
+		using in_edge_iterator				= InEdgeIter;
+		using traversal_workspace			= TraversalWorkspace;
+		template <template <class, class> class Heap = BinaryHeap>
+		using shortest_path_workspace		= ShortestPathWorkspace<Heap>;
+
+		static constexpr distance_type unreachable = std::numeric_limits<distance_type>::max();
+
+	// ------------------------------------------- GRAPH MAIN LOGIC -------------------------------------------
+	public:
+		Graph() 
+			:m_vertex_node_list(nullptr),
+			m_vertex_node_last(nullptr),
+			m_size(0),
+			m_edge_count(0),
+			m_edge_buffer_capacity(first_edge_buffer_capacity)
+			{};
+		// Presizes the graph for the expected number of vertices and edges, see reserve
+		Graph(size_type vertex_count, size_type edge_count): Graph() { reserve(vertex_count, edge_count); }
+		Graph(std::initializer_list<edge_type> list): Graph()
+		{
+			for (auto i = list.begin(); i != list.end(); ++i)
+				addEdge(*i);
+		}
+		Graph(const Graph& g) : Graph() { operator=(g); }
+		Graph(Graph&& g) : Graph() { swap(g, *this); }
+		Graph& operator=(const Graph& g)
+		{
+			if (this == &g)
+				return *this;
+
+			destroyGraph();
+			try
+			{
+				copyGraph(g);
+			}
+			catch (...)
+			{
+				destroyGraph();
+				throw;
+			}
+			return *this;
+		}
+		Graph& operator=(Graph&& g) { swap(g, *this); return *this; }
+		~Graph() { destroyGraph(); }
+
+		template <class Ty, std::enable_if_t<std::is_same<std::decay_t<Ty>, vertex_type>::value, int> = 0>
+		std::tuple<vertex_iterator, bool> addVertex(Ty&& vertex)
+		{
+			auto search = findVertexHelper(vertex);
+			if (search != nullptr)
+				return std::make_tuple(vertex_iterator(search), false);
+
+			// Claim the id slot first so nothing can fail once the node exists besides the index
+			m_vertex_nodes.push_back(nullptr);
+			VertexNode* node = nullptr;
+			try
+			{
+				node = m_vertex_node_allocator.allocate(1);
+				Stats::allocation(sizeof(VertexNode));
+				constructVertexNode(node, std::forward<Ty>(vertex));
+			}
+			catch (...)
+			{
+				if (node != nullptr)
+					m_vertex_node_allocator.deallocate(node, 1);
+				m_vertex_nodes.pop_back();
+				throw;
+			}
+			try
+			{
+				indexVertexHelper(node);
+			}
+			catch (...)
+			{
+				m_vertex_nodes.pop_back();
+				throw;
+			}
+			node->id = m_size;
+			m_vertex_nodes.back() = node;
+			linkVertexHelper(node);
+			return std::make_tuple(vertex_iterator(node), true);
+		}
+
+		void addVertex(std::initializer_list<vertex_type> list)
+		{
+			for (auto i = list.begin(); i != list.end(); ++i)
+				addVertex(*i);
+		}
+
+		std::tuple<edge_iterator, bool> addEdge(const edge_type& edge)
+		{ return addEdgeCaller(edge); }
+
+		void addEdge(std::initializer_list<edge_type> list)
+		{
+			for (auto i = list.begin(); i != list.end(); ++i)
+				addEdge(*i);
+		}
+
+		// Bulk insertion in O(V + n). Vertices are resolved once per edge, the edges are counted per source
+		// so each source grows its edge records at most once, then they are scattered into the new room and
+		// linked with the usual duplicate checks. The edges end up exactly as with repeated addEdge.
+		template <class InputIt>
+		void addEdges(InputIt first, InputIt last)
+		{
+			// Undirected edges are recorded once and scattered in both directions
+			std::vector<EdgeRecord> records;
+			if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>::value)
+				records.reserve(size_type(std::distance(first, last)));
+
+			// Edge lists are usually grouped by source so the previous source is checked before the index
+			VertexNode* from = nullptr;
+			for (; first != last; ++first)
+			{
+				const edge_type& edge = *first;
+				if (from == nullptr || !vertex_equal{}(from->vertex(), std::get<0>(edge)))
+					from = std::get<0>(addVertex(std::get<0>(edge))).m_vertex_node;
+				auto to = std::get<0>(addVertex(std::get<1>(edge))).m_vertex_node;
+				records.push_back({ from, to, edgeWeight(edge) });
+			}
+
+			// Edges per source by id and the sources in order of their first edge
+			std::vector<size_type> counts(m_size, 0);
+			std::vector<VertexNode*> sources;
+			auto count = [&](VertexNode* node)
+			{
+				if (counts[node->id]++ == 0)
+					sources.push_back(node);
+			};
+			for (auto& record : records)
+			{
+				if constexpr (!Directed)
+					count(record.to);
+				count(record.from);
+			}
+
+			// The counts restart at zero and serve as the cursors of the scatter
+			for (auto node : sources)
+			{
+				reserveEdgeHelper(node, counts[node->id]);
+				counts[node->id] = 0;
+			}
+			auto scatter = [&](VertexNode* node, VertexNode* to, weight_type weight)
+			{
+				auto& edge = node->edges.data()[node->edges.size + counts[node->id]++];
+				edge.vertex_node = to;
+				setEdgeWeight(edge, weight);
+			};
+			for (auto& record : records)
+			{
+				// Same order as addEdgeCaller, which adds the mirrored edge first
+				if constexpr (!Directed)
+					scatter(record.to, record.from, record.weight);
+				scatter(record.from, record.to, record.weight);
+			}
+			records = std::vector<EdgeRecord>();
+
+			for (auto node : sources)
+				linkFreshEdgesHelper(node, counts[node->id]);
+		}
+
+		// Removes the vertex with all edges from and to it in O(degree + in-degree), returns whether it was
+		// in the graph. The vertex with the highest id takes over the id of the removed one. Directed graphs
+		// need InEdges (see BidirectionalGraph) to find the edges pointing at the vertex.
+		bool removeVertex(const vertex_type& vertex)
+		{
+			static_assert(!Directed || InEdges, "Removing vertices of directed graphs needs the in-edges, use BidirectionalGraph");
+			auto search = findVertexHelper(vertex);
+			if (search == nullptr)
+				return false;
+			removeVertexHelper(search);
+			return true;
+		}
+
+		// Returns the iterator following the removed vertex
+		vertex_iterator removeVertex(vertex_iterator vertex)
+		{
+			static_assert(!Directed || InEdges, "Removing vertices of directed graphs needs the in-edges, use BidirectionalGraph");
+			if (vertex.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+			auto next = vertex.m_vertex_node->next;
+			removeVertexHelper(vertex.m_vertex_node);
+			return vertex_iterator(next);
+		}
+
+		// Removes the edge, for undirected graphs together with its mirrored edge.
+		// Returns whether the edge was in the graph, the weight isn't compared.
+		bool removeEdge(const edge_type& edge)
+		{
+			auto from = findVertexHelper(std::get<0>(edge));
+			auto position = findEdgeHelper(from, findVertexHelper(std::get<1>(edge)));
+			if (position == no_edge)
+				return false;
+			removeEdgeHelper(from, position);
+			return true;
+		}
+
+		// The last edge of the start vertex takes the place of the removed one, so iterators to that edge
+		// are invalidated. The returned iterator points at it, erasing while iterating visits every edge once.
+		edge_iterator removeEdge(edge_iterator edge)
+		{
+			if (edge.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+			removeEdgeHelper(edge.m_vertex_node, edge.m_position);
+			if (edge.m_position == edge.m_vertex_node->edges.size)
+				return edge_end();
+			return edge;
+		}
+
+		// Capacity hints for an upcoming load. Presizes the vertex index so it doesn't rehash and, with an
+		// arena allocator, the vertex node arena so it doesn't grow block by block. edge_count counts the
+		// edges as added, when their average degree exceeds the first edge buffer the first buffer of every
+		// vertex that outgrows its inline records gets that many, so typical vertices move at most once.
+		void reserve(size_type vertex_count, size_type edge_count)
+		{
+			if (vertex_count != 0)
+			{
+				// Undirected edges are stored in both directions
+				auto degree = ((Directed ? 1 : 2) * edge_count + vertex_count - 1) / vertex_count;
+				if (degree > m_edge_buffer_capacity)
+					m_edge_buffer_capacity = degree;
+			}
+			if constexpr (hashed)
+				m_vertex_index.reserve(vertex_count);
+			m_vertex_nodes.reserve(vertex_count);
+			if constexpr (is_reservable_allocator<vertex_node_allocator_type>::value)
+				m_vertex_node_allocator.reserve(vertex_count);
+			if constexpr (out_of_line)
+				m_vertex_pool.reserve(vertex_count);
+		}
+
+		vertex_iterator findVertex(const vertex_type& vertex) const
+		{
+			auto search = findVertexHelper(vertex);
+			if (search == nullptr)
+				return end();
+			return vertex_iterator(search);
+		}
+
+		edge_iterator findEdge(const edge_type& edge) const
+		{
+			auto from = findVertex(std::get<0>(edge)).m_vertex_node;
+			auto to = findVertex(std::get<1>(edge)).m_vertex_node;
+
+			auto position = findEdgeHelper(from, to);
+			if (position == no_edge)
+				return edge_end();
+			return edge_iterator(from, position);
+		}
+
+		constexpr vertex_iterator begin() const noexcept { return vertex_iterator(m_vertex_node_list); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, 0); }
+		static constexpr in_edge_iterator in_edge_end() noexcept { return in_edge_iterator(nullptr, 0); }
+
+		size_type size() const noexcept { return m_size; }
+		bool empty() const noexcept { return m_size == 0; }
+		// Counts both directions of undirected edges, like CsrGraph
+		size_type edgeCount() const noexcept { return m_edge_count; }
+
+		// Number of edges starting at the vertex
+		size_type degree(vertex_iterator vertex) const
+		{
+			if (vertex.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+			return vertex.m_vertex_node->edges.size;
+		}
+		// Number of edges pointing at the vertex, for undirected graphs the same as its degree
+		size_type inDegree(vertex_iterator vertex) const
+		{
+			if (vertex.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+			return vertex.m_vertex_node->in_degree;
+		}
+
+		// Single source shortest paths. Returns the distance and the predecessor on a shortest path of every
+		// vertex, indexed by vertex id, unreachable vertices get unreachable and end(). The heap is pluggable,
+		// BinaryHeap, QuadHeap or RadixHeap for integer weights.
+		template <template <class, class> class Heap = BinaryHeap>
+		std::tuple<std::vector<distance_type>, std::vector<vertex_iterator>> shortestPaths(vertex_iterator source) const
+		{
+			if (source.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+
+			ShortestPathSearch<Heap> search;
+			dijkstraHelper(search, source.m_vertex_node, nullptr);
+
+			std::vector<distance_type> distances(m_size, unreachable);
+			std::vector<vertex_iterator> predecessors(m_size, end());
+			for (auto node = m_vertex_node_list; node != nullptr; node = node->next)
+			{
+				distances[node->id] = search.distance(node);
+				predecessors[node->id] = vertex_iterator(search.predecessor(node));
+			}
+			return std::make_tuple(std::move(distances), std::move(predecessors));
+		}
+
+		// Point to point shortest path, the search stops as soon as the target is settled.
+		// Returns the distance and the path from source to target, or unreachable and an empty path.
+		template <template <class, class> class Heap = BinaryHeap>
+		std::tuple<distance_type, std::vector<vertex_iterator>> shortestPath(vertex_iterator source, vertex_iterator target) const
+		{
+			shortest_path_workspace<Heap> workspace;
+			return shortestPath(source, target, workspace);
+		}
+
+		template <template <class, class> class Heap>
+		std::tuple<distance_type, std::vector<vertex_iterator>> shortestPath(vertex_iterator source, vertex_iterator target,
+			shortest_path_workspace<Heap>& workspace) const
+		{
+			if (source.m_vertex_node == nullptr || target.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+
+			auto& search = workspace.m_forward;
+			dijkstraHelper(search, source.m_vertex_node, target.m_vertex_node);
+			auto distance = search.distance(target.m_vertex_node);
+			if (distance == unreachable)
+				return std::make_tuple(unreachable, std::vector<vertex_iterator>());
+
+			std::vector<vertex_iterator> path;
+			for (auto node = target.m_vertex_node; node != nullptr; node = search.predecessor(node))
+				path.push_back(vertex_iterator(node));
+			std::reverse(path.begin(), path.end());
+			return std::make_tuple(distance, std::move(path));
+		}
+
+		// Bidirectional point to point search growing a forward and a backward ball until they meet,
+		// settles far fewer vertices than shortestPath on large graphs
+		template <template <class, class> class Heap = BinaryHeap>
+		std::tuple<distance_type, std::vector<vertex_iterator>> bidirectionalShortestPath(vertex_iterator source, vertex_iterator target) const
+		{
+			shortest_path_workspace<Heap> workspace;
+			return bidirectionalShortestPath(source, target, workspace);
+		}
+
+		template <template <class, class> class Heap>
+		std::tuple<distance_type, std::vector<vertex_iterator>> bidirectionalShortestPath(vertex_iterator source, vertex_iterator target,
+			shortest_path_workspace<Heap>& workspace) const
+		{
+			static_assert(!Directed || InEdges, "Bidirectional search on directed graphs needs the in-edges");
+			if (source.m_vertex_node == nullptr || target.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+			return bidirectionalDijkstraHelper(workspace, source.m_vertex_node, target.m_vertex_node);
+		}
+
+		// Breadth first traversal from start. The visitor is called with the vertex_iterator and optionally
+		// the hop distance of every reached vertex, returning false from it stops the traversal.
+		template <class Visitor>
+		void bfs(vertex_iterator start, Visitor&& visitor) const
+		{
+			traversal_workspace workspace;
+			bfs(start, std::forward<Visitor>(visitor), workspace);
+		}
+
+		template <class Visitor>
+		void bfs(vertex_iterator start, Visitor&& visitor, traversal_workspace& workspace) const
+		{
+			if (start.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+
+			workspace.start(m_size);
+			auto& queue = workspace.m_queue;
+			workspace.visit(start.m_vertex_node);
+			queue.push_back(start.m_vertex_node);
+
+			// The queue is processed one level at a time to know the depth without storing it per vertex
+			size_type head = 0;
+			for (size_type depth = 0; head != queue.size(); ++depth)
+			{
+				for (size_type level_end = queue.size(); head != level_end; ++head)
+				{
+					auto node = queue[head];
+					if (!visitHelper(visitor, node, depth))
+						return;
+					for (const auto& edge : node->edges)
+						if (workspace.visit(edge.vertex_node))
+							queue.push_back(edge.vertex_node);
+				}
+			}
+		}
+
+		// Depth first traversal from start visiting vertices in preorder. The visitor is called the same way
+		// as with bfs, with the depth in the DFS tree.
+		template <class Visitor>
+		void dfs(vertex_iterator start, Visitor&& visitor) const
+		{
+			traversal_workspace workspace;
+			dfs(start, std::forward<Visitor>(visitor), workspace);
+		}
+
+		template <class Visitor>
+		void dfs(vertex_iterator start, Visitor&& visitor, traversal_workspace& workspace) const
+		{
+			if (start.m_vertex_node == nullptr)
+				throw std::runtime_error("Invalid iterator");
+
+			// Explicit stack of (vertex, position of the next edge to follow) so deep graphs can't overflow
+			// the call stack
+			workspace.start(m_size);
+			auto& stack = workspace.m_stack;
+			workspace.visit(start.m_vertex_node);
+			if (!visitHelper(visitor, start.m_vertex_node, 0))
+				return;
+			stack.emplace_back(start.m_vertex_node, 0);
+
+			while (!stack.empty())
+			{
+				auto& edges = stack.back().first->edges;
+				auto& position = stack.back().second;
+				while (position != edges.size && !workspace.visit(edges.data()[position].vertex_node))
+					++position;
+
+				if (position == edges.size)
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				auto node = edges.data()[position++].vertex_node;
+				if (!visitHelper(visitor, node, stack.size()))
+					return;
+				stack.emplace_back(node, 0);
+			}
+		}
+
+		// Connected components through union find over the dense ids, directed graphs get their weakly
+		// connected components. Returns the number of components and the component of every vertex by id,
+		// components are numbered in order of their lowest id.
+		std::tuple<size_type, std::vector<size_type>> connectedComponents() const
+		{
+			DisjointSets<size_type> sets(m_size);
+			for (auto search = m_vertex_node_list; search != nullptr; search = search->next)
+				for (const auto& edge : search->edges)
+					sets.unite(search->id, edge.vertex_node->id);
+			return sets.labels();
+		}
+
+		// Strongly connected components with an iterative Tarjan search. Returns the number of components
+		// and the component of every vertex by id, components are numbered in reverse topological order
+		// of the condensation, so edges between components only go from higher to lower numbers.
+		std::tuple<size_type, std::vector<size_type>> stronglyConnectedComponents() const
+		{
+			constexpr size_type unvisited = size_type(-1);
+			std::vector<size_type> order(m_size, unvisited);
+			std::vector<size_type> low(m_size);
+			std::vector<size_type> components(m_size, unvisited);
+			std::vector<VertexNode*> open;
+			// Explicit call stack of (vertex, position of the next edge to follow)
+			std::vector<std::pair<VertexNode*, size_type>> stack;
+			size_type next_order = 0;
+			size_type count = 0;
+
+			for (auto root : m_vertex_nodes)
+			{
+				if (order[root->id] != unvisited)
+					continue;
+				order[root->id] = low[root->id] = next_order++;
+				open.push_back(root);
+				stack.emplace_back(root, 0);
+
+				while (!stack.empty())
+				{
+					auto node = stack.back().first;
+					auto& position = stack.back().second;
+					if (position != node->edges.size)
+					{
+						auto next = node->edges.data()[position++].vertex_node;
+						if (order[next->id] == unvisited)
+						{
+							order[next->id] = low[next->id] = next_order++;
+							open.push_back(next);
+							stack.emplace_back(next, 0);
+						}
+						// Only vertices still open are in the component being built
+						else if (components[next->id] == unvisited)
+							low[node->id] = std::min(low[node->id], order[next->id]);
+						continue;
+					}
+
+					stack.pop_back();
+					if (!stack.empty())
+					{
+						auto parent = stack.back().first;
+						low[parent->id] = std::min(low[parent->id], low[node->id]);
+					}
+					if (low[node->id] != order[node->id])
+						continue;
+
+					VertexNode* member;
+					do
+					{
+						member = open.back();
+						open.pop_back();
+						components[member->id] = count;
+					} while (member != node);
+					++count;
+				}
+			}
+			return std::make_tuple(count, std::move(components));
+		}
+
+		friend void swap(Graph& lhs, Graph& rhs)
+		{
+			// Enable ADL
+			using std::swap;
+			swap(lhs.m_vertex_node_list, rhs.m_vertex_node_list);
+			swap(lhs.m_vertex_node_last, rhs.m_vertex_node_last);
+			swap(lhs.m_vertex_index, rhs.m_vertex_index);
+			swap(lhs.m_vertex_nodes, rhs.m_vertex_nodes);
+			swap(lhs.m_vertex_node_allocator, rhs.m_vertex_node_allocator);
+			swap(lhs.m_edge_allocator, rhs.m_edge_allocator);
+			if constexpr (out_of_line)
+				swap(lhs.m_vertex_pool, rhs.m_vertex_pool);
+			swap(lhs.m_size, rhs.m_size);
+			swap(lhs.m_edge_count, rhs.m_edge_count);
+			swap(lhs.m_edge_buffer_capacity, rhs.m_edge_buffer_capacity);
+		}
+
+		template <class, bool, bool, class, class>
+		friend class CsrGraph;
+		template <class, bool, bool, class, class>
+		friend class CompressedCsrGraph;
+	private:
+		VertexNode* m_vertex_node_list;
+		VertexNode* m_vertex_node_last;
+		vertex_index_type m_vertex_index;
+		// Vertex nodes by id
+		std::vector<VertexNode*, vertex_table_allocator_type> m_vertex_nodes;
+		vertex_node_allocator_type m_vertex_node_allocator;
+		edge_allocator_type m_edge_allocator;
+		vertex_pool_type m_vertex_pool;
+		size_type m_size;
+		// Counts both directions of undirected edges, like CsrGraph
+		size_type m_edge_count;
+		// Capacity of the first edge buffer of a vertex, raised by reserve
+		size_type m_edge_buffer_capacity;
+
+		// Edge Helpers ----------------
+
+		static constexpr size_type no_edge = size_type(-1);
+
+		std::tuple<edge_iterator, bool> addEdgeHelper(VertexNode* from, VertexNode* to, weight_type weight = weight_type(0))
+		{
+			auto position = findEdgeHelper(from, to);
+			if (position != no_edge)
+			{
+				Stats::duplicateEdge();
+				return std::make_tuple(edge_iterator(from, position), false);
+			}
+
+			// Room that isn't used when a later step throws is kept for the next edge
+			reserveRecordsHelper(from->edges, from->edges.size + 1);
+			if constexpr (InEdges)
+				reserveRecordsHelper(to->in_edges, to->in_edges.size + 1);
+			indexEdgeHelper(from, to, from->edges.size);
+
+			linkEdgeHelper(from, to, weight);
+			return std::make_tuple(edge_iterator(from, from->edges.size - 1), true);
+		}
+
+		struct EdgeRecord
+		{
+			VertexNode* from;
+			VertexNode* to;
+			weight_type weight;
+		};
+
+		// Links the count records scattered right after the edges of from, dropping the duplicates. Records
+		// only move towards the front, so each is read before its position is reused. If the index or the
+		// in-edges can't grow the records not yet linked are left as spare room.
+		void linkFreshEdgesHelper(VertexNode* from, size_type count)
+		{
+			auto records = from->edges.data();
+			for (auto fresh = from->edges.size, end = fresh + count; fresh != end; ++fresh)
+			{
+				auto edge = records[fresh];
+				if (findEdgeHelper(from, edge.vertex_node) != no_edge)
+				{
+					Stats::duplicateEdge();
+					continue;
+				}
+				if constexpr (InEdges)
+					reserveRecordsHelper(edge.vertex_node->in_edges, edge.vertex_node->in_edges.size + 1);
+				if (from->edge_index != nullptr)
+					from->edge_index->emplace(edge.vertex_node, from->edges.size);
+
+				if constexpr (Weighted)
+					linkEdgeHelper(from, edge.vertex_node, edge.weight);
+				else
+					linkEdgeHelper(from, edge.vertex_node, weight_type(0));
+			}
+		}
+
+		// Appends the edge in room reserved beforehand, which keeps the edges in insertion order
+		void linkEdgeHelper(VertexNode* from, VertexNode* to, weight_type weight) noexcept
+		{
+			auto& edge = from->edges.data()[from->edges.size];
+			edge.vertex_node = to;
+			setEdgeWeight(edge, weight);
+			if constexpr (InEdges)
+			{
+				edge.in_position = to->in_edges.size;
+				to->in_edges.data()[to->in_edges.size++] = InEdge{ from, from->edges.size };
+			}
+			++from->edges.size;
+			++to->in_degree;
+			++m_edge_count;
+			Stats::degreeReached(from->id, from->edges.size);
+		}
+
+		// Removes an edge in O(1) by moving the last edge of from into its position, the edge index is
+		// dropped again once the degree halves
+		void unlinkEdgeHelper(VertexNode* from, size_type position) noexcept
+		{
+			auto records = from->edges.data();
+			auto last = from->edges.size - 1;
+			auto to = records[position].vertex_node;
+			if (from->edge_index != nullptr)
+			{
+				if (last < edge_index_threshold / 2)
+					destroyEdgeIndex(from);
+				else
+				{
+					from->edge_index->erase(to);
+					if (position != last)
+						from->edge_index->find(records[last].vertex_node)->second = position;
+				}
+			}
+
+			// Before the move below, the in-edge moved here may belong to the last edge of from
+			if constexpr (InEdges)
+				removeInEdgeHelper(to, records[position].in_position);
+			if (position != last)
+			{
+				records[position] = records[last];
+				if constexpr (InEdges)
+					records[position].vertex_node->in_edges.data()[records[position].in_position].position = position;
+			}
+			from->edges.size = last;
+			--to->in_degree;
+			--m_edge_count;
+			shrinkRecordsHelper(from->edges);
+		}
+
+		void removeInEdgeHelper(VertexNode* to, size_type in_position) noexcept
+		{
+			auto in_records = to->in_edges.data();
+			auto last = to->in_edges.size - 1;
+			if (in_position != last)
+			{
+				in_records[in_position] = in_records[last];
+				auto& moved = in_records[in_position];
+				moved.source->edges.data()[moved.position].in_position = in_position;
+			}
+			to->in_edges.size = last;
+			shrinkRecordsHelper(to->in_edges);
+		}
+
+		// Makes room for count more edges of from, and for its edge index once they reach the threshold
+		void reserveEdgeHelper(VertexNode* from, size_type count)
+		{
+			reserveRecordsHelper(from->edges, from->edges.size + count);
+			if (from->edge_index == nullptr && from->edges.size + count >= edge_index_threshold)
+				buildEdgeIndex(from, from->edges.size + count);
+			else if (from->edge_index != nullptr)
+				from->edge_index->reserve(from->edge_index->size() + count);
+		}
+
+		// Makes room for count records. Records that outgrow the node move to a buffer of the first edge
+		// buffer capacity, later buffers double at least.
+		template <class T>
+		void reserveRecordsHelper(EdgeArray<T>& array, size_type count)
+		{
+			if (count <= array.capacity)
+				return;
+
+			auto capacity = array.capacity == inline_edge_capacity ? m_edge_buffer_capacity : 2 * array.capacity;
+			if (capacity < count)
+				capacity = count;
+			typename allocator_type::template rebind<T>::other allocator(m_edge_allocator);
+			auto records = allocator.allocate(capacity);
+			Stats::allocation(capacity * sizeof(T));
+			std::copy(array.begin(), array.end(), records);
+			deallocateRecordsHelper(array);
+			array.records = records;
+			array.capacity = capacity;
+		}
+
+		// Moves the records back into the node once few are left
+		template <class T>
+		void shrinkRecordsHelper(EdgeArray<T>& array) noexcept
+		{
+			if (array.capacity == inline_edge_capacity || array.size > inline_edge_capacity / 2)
+				return;
+			typename allocator_type::template rebind<T>::other allocator(m_edge_allocator);
+			auto records = array.records;
+			auto capacity = array.capacity;
+			std::copy(records, records + array.size, array.inline_records);
+			allocator.deallocate(records, capacity);
+			array.capacity = inline_edge_capacity;
+		}
+
+		template <class T>
+		void deallocateRecordsHelper(EdgeArray<T>& array) noexcept
+		{
+			if (array.capacity == inline_edge_capacity)
+				return;
+			typename allocator_type::template rebind<T>::other allocator(m_edge_allocator);
+			allocator.deallocate(array.records, array.capacity);
+			array.capacity = inline_edge_capacity;
+		}
+
+		// Records are trivially destructible, only the buffers of vertices that outgrew their node are freed
+		void destroyEdgeStorage(VertexNode* node) noexcept
+		{
+			deallocateRecordsHelper(node->edges);
+			node->edges.size = 0;
+			if constexpr (InEdges)
+			{
+				deallocateRecordsHelper(node->in_edges);
+				node->in_edges.size = 0;
+			}
+		}
+
+		void removeEdgeHelper(VertexNode* from, size_type position) noexcept
+		{
+			auto to = from->edges.data()[position].vertex_node;
+			unlinkEdgeHelper(from, position);
+			if constexpr (!Directed)
+			{
+				if (to != from)
+					unlinkEdgeHelper(to, findEdgeHelper(to, from));
+			}
+		}
+
+		// Adds the edge about to be linked at position to the edge index of from, building the index once
+		// the degree reaches the threshold
+		void indexEdgeHelper(VertexNode* from, VertexNode* to, size_type position)
+		{
+			if (from->edge_index != nullptr)
+			{
+				from->edge_index->emplace(to, position);
+				return;
+			}
+			if (position + 1 < edge_index_threshold)
+				return;
+
+			// If the emplace throws the index is still consistent with the linked edges
+			buildEdgeIndex(from, 2 * edge_index_threshold);
+			from->edge_index->emplace(to, position);
+		}
+
+		// Builds the edge index of a node from its current edges
+		void buildEdgeIndex(VertexNode* from, size_type capacity)
+		{
+			edge_index_node_allocator_type index_allocator(m_edge_allocator);
+			auto index = index_allocator.allocate(1);
+			Stats::allocation(sizeof(EdgeIndex));
+			try
+			{
+				index_allocator.construct(index, edge_index_allocator_type(m_edge_allocator));
+			}
+			catch (...)
+			{
+				index_allocator.deallocate(index, 1);
+				throw;
+			}
+			try
+			{
+				index->reserve(capacity);
+				auto records = from->edges.data();
+				for (size_type position = 0; position != from->edges.size; ++position)
+					index->emplace(records[position].vertex_node, position);
+			}
+			catch (...)
+			{
+				index_allocator.destroy(index);
+				index_allocator.deallocate(index, 1);
+				throw;
+			}
+			from->edge_index = index;
+		}
+
+		void destroyEdgeIndex(VertexNode* node)
+		{
+			if (node->edge_index == nullptr)
+				return;
+			edge_index_node_allocator_type index_allocator(m_edge_allocator);
+			index_allocator.destroy(node->edge_index);
+			index_allocator.deallocate(node->edge_index, 1);
+			node->edge_index = nullptr;
+		}
+
+		// Undirected edges are stored once in each direction
+		std::tuple<edge_iterator, bool> addEdgeCaller(const edge_type& edge)
+		{
+			auto vertex_from_node = std::get<0>(addVertex(std::get<0>(edge))).m_vertex_node;
+			auto vertex_to_node = std::get<0>(addVertex(std::get<1>(edge))).m_vertex_node;
+
+			if constexpr (!Directed)
+				addEdgeHelper(vertex_to_node, vertex_from_node, edgeWeight(edge));
+			return addEdgeHelper(vertex_from_node, vertex_to_node, edgeWeight(edge));
+		}
+
+		static constexpr void setEdgeWeight(Edge& edge, weight_type weight) noexcept
+		{
+			if constexpr (Weighted)
+				edge.weight = weight;
+		}
+
+		static constexpr weight_type edgeWeight(const edge_type& edge)
+		{
+			if constexpr (Weighted)
+				return std::get<2>(edge);
+			else
+				return weight_type(0);
+		}
+
+		// Returns the position of the edge from one vertex node to the other or no_edge if there is no such edge
+		size_type findEdgeHelper(VertexNode* from, VertexNode* to) const
+		{
+			if (from == nullptr || to == nullptr)
+				return no_edge;
+
+			if (from->edge_index != nullptr)
+			{
+				Stats::edgeLookup(1);
+				auto search = from->edge_index->find(to);
+				return search == from->edge_index->end() ? no_edge : search->second;
+			}
+
+			auto records = from->edges.data();
+			size_type position = 0;
+			while (position != from->edges.size && records[position].vertex_node != to)
+				++position;
+			Stats::edgeLookup(position + 1);
+			return position == from->edges.size ? no_edge : position;
+		}
+
+		// ---------------- Edge Helpers
+
+		// Traversal Helpers ----------------
+
+		static constexpr distance_type edgeCost(const Edge& edge)
+		{
+			if constexpr (Weighted)
+			{
+				// Also rejects NaN
+				if constexpr (std::is_signed<weight_type>::value)
+					if (!(edge.weight >= weight_type(0)))
+						throw std::domain_error("Shortest paths require non-negative edge weights");
+				return distance_type(edge.weight);
+			}
+			else
+				return 1;
+		}
+
+		template <template <class, class> class Heap>
+		void dijkstraHelper(ShortestPathSearch<Heap>& search, VertexNode* source, VertexNode* target) const
+		{
+			search.start(m_size);
+			search.relax(source, 0, nullptr);
+			while (!search.m_heap.empty())
+			{
+				auto [distance, node] = search.m_heap.top();
+				search.m_heap.pop();
+				// Stale entry of a vertex whose distance improved after it was pushed
+				if (distance != search.distance(node))
+					continue;
+				if (node == target)
+					return;
+
+				for (const auto& edge : node->edges)
+					search.relax(edge.vertex_node, distance + edgeCost(edge), node);
+			}
+		}
+
+		template <template <class, class> class Heap>
+		std::tuple<distance_type, std::vector<vertex_iterator>> bidirectionalDijkstraHelper(ShortestPathWorkspace<Heap>& workspace,
+			VertexNode* source, VertexNode* target) const
+		{
+			auto& forward = workspace.m_forward;
+			auto& backward = workspace.m_backward;
+			forward.start(m_size);
+			backward.start(m_size);
+			forward.relax(source, 0, nullptr);
+			backward.relax(target, 0, nullptr);
+
+			auto best = source == target ? distance_type(0) : unreachable;
+			auto meeting = source == target ? source : nullptr;
+			while (!forward.m_heap.empty() && !backward.m_heap.empty())
+			{
+				// No path through an unsettled vertex can beat the best one any more
+				if (forward.m_heap.top().first + backward.m_heap.top().first >= best)
+					break;
+
+				// Expand the side with the smaller frontier
+				bool expand_forward = forward.m_heap.size() <= backward.m_heap.size();
+				auto& search = expand_forward ? forward : backward;
+				auto& other = expand_forward ? backward : forward;
+
+				auto [distance, node] = search.m_heap.top();
+				search.m_heap.pop();
+				if (distance != search.distance(node))
+					continue;
+
+				auto relax = [&](VertexNode* next, const Edge& edge)
+				{
+					search.relax(next, distance + edgeCost(edge), node);
+					auto other_distance = other.distance(next);
+					if (other_distance != unreachable && search.distance(next) + other_distance < best)
+					{
+						best = search.distance(next) + other_distance;
+						meeting = next;
+					}
+				};
+				// Undirected graphs search backward along the same edges, directed ones along the in-edges
+				if constexpr (InEdges)
+				{
+					if (!expand_forward)
+					{
+						for (const auto& in_edge : node->in_edges)
+							relax(in_edge.source, in_edge.source->edges.data()[in_edge.position]);
+						continue;
+					}
+				}
+				for (const auto& edge : node->edges)
+					relax(edge.vertex_node, edge);
+			}
+
+			if (meeting == nullptr)
+				return std::make_tuple(unreachable, std::vector<vertex_iterator>());
+
+			std::vector<vertex_iterator> path;
+			for (auto node = meeting; node != nullptr; node = forward.predecessor(node))
+				path.push_back(vertex_iterator(node));
+			std::reverse(path.begin(), path.end());
+			for (auto node = backward.predecessor(meeting); node != nullptr; node = backward.predecessor(node))
+				path.push_back(vertex_iterator(node));
+			return std::make_tuple(best, std::move(path));
+		}
+
+		// Calls a traversal visitor, supporting visitors with or without the depth and with or without a result
+		template <class Visitor>
+		static bool visitHelper(Visitor& visitor, VertexNode* node, size_type depth)
+		{
+			if constexpr (std::is_invocable<Visitor&, vertex_iterator, size_type>::value)
+			{
+				if constexpr (std::is_void<std::invoke_result_t<Visitor&, vertex_iterator, size_type>>::value)
+					return visitor(vertex_iterator(node), depth), true;
+				else
+					return bool(visitor(vertex_iterator(node), depth));
+			}
+			else
+			{
+				if constexpr (std::is_void<std::invoke_result_t<Visitor&, vertex_iterator>>::value)
+					return visitor(vertex_iterator(node)), true;
+				else
+					return bool(visitor(vertex_iterator(node)));
+			}
+		}
+
+		void linkVertexHelper(VertexNode* node) noexcept
+		{
+			node->prev = m_vertex_node_last;
+			if (m_vertex_node_last == nullptr)
+				m_vertex_node_list = node;
+			else
+				m_vertex_node_last->next = node;
+			m_vertex_node_last = node;
+			++m_size;
+		}
+
+		void removeVertexHelper(VertexNode* node)
+		{
+			// Undirected edges are mirrored so the incoming edges are found through the outgoing ones
+			if constexpr (!Directed)
+			{
+				for (const auto& edge : node->edges)
+					if (edge.vertex_node != node)
+						unlinkEdgeHelper(edge.vertex_node, findEdgeHelper(edge.vertex_node, node));
+			}
+			while (node->edges.size != 0)
+				unlinkEdgeHelper(node, node->edges.size - 1);
+
+			if constexpr (InEdges)
+			{
+				while (node->in_edges.size != 0)
+				{
+					auto in_edge = node->in_edges.data()[node->in_edges.size - 1];
+					unlinkEdgeHelper(in_edge.source, in_edge.position);
+				}
+			}
+
+			if (node->prev == nullptr)
+				m_vertex_node_list = node->next;
+			else
+				node->prev->next = node->next;
+			if (node->next == nullptr)
+				m_vertex_node_last = node->prev;
+			else
+				node->next->prev = node->prev;
+
+			// Keep ids dense by moving the last id into the freed slot
+			auto last = m_vertex_nodes.back();
+			last->id = node->id;
+			m_vertex_nodes[node->id] = last;
+			m_vertex_nodes.pop_back();
+
+			if constexpr (hashed)
+				m_vertex_index.erase(std::cref(node->vertex()));
+			destroyEdgeIndex(node);
+			destroyEdgeStorage(node);
+			destroyVertexNode(node);
+			m_vertex_node_allocator.deallocate(node, 1);
+			--m_size;
+		}
+
+		// Structural O(V + E) copy into an empty graph, nodes are mapped through their dense ids so no
+		// lookups or duplicate checks are needed and isolated vertices are kept
+		void copyGraph(const Graph& g)
+		{
+			if constexpr (is_reservable_allocator<vertex_node_allocator_type>::value)
+				m_vertex_node_allocator.reserve(g.m_size);
+			if constexpr (hashed)
+				m_vertex_index.reserve(g.m_size);
+			if constexpr (out_of_line)
+				m_vertex_pool.reserve(g.m_size);
+
+			// Ids are preserved so the id table doubles as the map from old to new nodes
+			m_vertex_nodes.assign(g.m_size, nullptr);
+			for (auto search = g.m_vertex_node_list; search != nullptr; search = search->next)
+			{
+				// The node isn't linked yet so destroyGraph can't free it, indexVertexHelper releases it on failure
+				auto node = m_vertex_node_allocator.allocate(1);
+				Stats::allocation(sizeof(VertexNode));
+				try
+				{
+					constructVertexNode(node, search->vertex());
+				}
+				catch (...)
+				{
+					m_vertex_node_allocator.deallocate(node, 1);
+					throw;
+				}
+				indexVertexHelper(node);
+				node->id = search->id;
+				linkVertexHelper(node);
+				m_vertex_nodes[search->id] = node;
+			}
+
+			for (auto search = g.m_vertex_node_list; search != nullptr; search = search->next)
+			{
+				// Positions are kept so the copied in-positions stay valid
+				auto from = m_vertex_nodes[search->id];
+				reserveRecordsHelper(from->edges, search->edges.size);
+				for (const auto& edge : search->edges)
+				{
+					auto& copy = from->edges.data()[from->edges.size++];
+					copy = edge;
+					copy.vertex_node = m_vertex_nodes[edge.vertex_node->id];
+					++copy.vertex_node->in_degree;
+					++m_edge_count;
+					Stats::degreeReached(from->id, from->edges.size);
+				}
+				if constexpr (InEdges)
+				{
+					reserveRecordsHelper(from->in_edges, search->in_edges.size);
+					for (const auto& in_edge : search->in_edges)
+						from->in_edges.data()[from->in_edges.size++] = InEdge{ m_vertex_nodes[in_edge.source->id], in_edge.position };
+				}
+				if (search->edge_index != nullptr)
+					buildEdgeIndex(from, search->edge_index->size());
+			}
+		}
+
+		// Returns the node with the vertex or nullptr if the vertex isn't in the graph
+		VertexNode* findVertexHelper(const vertex_type& vertex) const
+		{
+			if constexpr (hashed)
+			{
+				Stats::vertexLookup(1);
+				auto search = m_vertex_index.find(std::cref(vertex));
+				return search == m_vertex_index.end() ? nullptr : search->second;
+			}
+			else
+			{
+				size_type probes = 1;
+				auto search = m_vertex_node_list;
+				while (search != nullptr && !vertex_equal{}(vertex, search->vertex()))
+				{
+					search = search->next;
+					++probes;
+				}
+				Stats::vertexLookup(probes);
+				return search;
+			}
+		}
+
+		// Registers a freshly constructed node in the index, releasing the node if that fails
+		void indexVertexHelper(VertexNode* node)
+		{
+			if constexpr (hashed)
+			{
+				try
+				{
+					m_vertex_index.emplace(std::cref(node->vertex()), node);
+				}
+				catch (...)
+				{
+					destroyVertexNode(node);
+					m_vertex_node_allocator.deallocate(node, 1);
+					throw;
+				}
+			}
+		}
+
+		// Constructs the node in allocated memory, out of line vertices go into the pool first
+		template <class Ty>
+		void constructVertexNode(VertexNode* node, Ty&& vertex)
+		{
+			if constexpr (out_of_line)
+			{
+				auto stored = m_vertex_pool.create(std::forward<Ty>(vertex));
+				m_vertex_node_allocator.construct(node, stored);
+			}
+			else
+				m_vertex_node_allocator.construct(node, std::forward<Ty>(vertex));
+		}
+
+		// Destroys the node and its vertex, the memory of the node stays allocated
+		void destroyVertexNode(VertexNode* node) noexcept
+		{
+			if constexpr (out_of_line)
+				m_vertex_pool.destroy(node->stored_vertex);
+			m_vertex_node_allocator.destroy(node);
+		}
+
+		void destroyGraph()
+		{
+			// Arena allocators free their nodes in bulk so the edge buffers aren't returned one by one. Edge
+			// indices still have to be destroyed since they hold copies of the allocator owning their memory.
+			constexpr bool release_edges = is_releasable_allocator<edge_allocator_type>::value;
+			constexpr bool release_vertices = is_releasable_allocator<vertex_node_allocator_type>::value;
+
+			if constexpr (hashed)
+				m_vertex_index.clear();
+
+			auto search = m_vertex_node_list;
+			while (search != nullptr)
+			{
+				auto next = search->next;
+
+				// Deallocate edge storage
+				destroyEdgeIndex(search);
+				if constexpr (!release_edges)
+					destroyEdgeStorage(search);
+
+				destroyVertexNode(search);
+				if constexpr (!release_vertices)
+					m_vertex_node_allocator.deallocate(search, 1);
+				search = next;
+			}
+
+			if constexpr (release_edges)
+				m_edge_allocator.release();
+			if constexpr (release_vertices)
+				m_vertex_node_allocator.release();
+			if constexpr (out_of_line)
+				m_vertex_pool.release();
+			m_vertex_nodes.clear();
+			m_size = 0;
+			m_edge_count = 0;
+			m_vertex_node_list = nullptr;
+			m_vertex_node_last = nullptr;
+		}
+	};
+
+	// Weighted graph with the default equality, hash and allocator, e.g. WeightedGraph<int, std::uint16_t>
+	template <class V, class Weight, bool Directed = false>
+	using WeightedGraph = Graph<V, Directed, true, std::equal_to<V>, default_vertex_hash_t<V>, std::allocator<V>, Weight>;
+
+	// Directed graph keeping the in-edges of every vertex, see InEdges. Directed graphs need it for
+	// removeVertex and bidirectional search.
+	template <class V, bool Weighted = false, class Weight = int>
+	using BidirectionalGraph = Graph<V, true, Weighted, std::equal_to<V>, default_vertex_hash_t<V>, std::allocator<V>, Weight, true>;
+
 }	// namespace jvn
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// edge_list covers whitespace separated edge lists, SNAP files and weighted triples: one "u v [w]"
+	// per line, lines starting with # or % are comments and extra columns are ignored.
+	// matrix_market reads coordinate matrices, indices are made 0 based and symmetric matrices are
+	// mirrored. Pattern matrices give every edge weight 1, skew-symmetric ones need a directed graph and
+	// entries outside the declared size are rejected.
+	enum class EdgeListFormat
+	{
+		edge_list,
+		matrix_market
+	};
+
+	// Runs a task synchronously, what the reading functions use when no pool is passed
+	struct SequentialPool
+	{
+		constexpr size_t size() const noexcept { return 1; }
+		template <class Task>
+		void parallelFor(size_t count, Task&& task)
+		{
+			for (size_t i = 0; i < count; ++i)
+				task(i);
+		}
+	};
+
+	// Reader Helpers ----------------
+
+	struct EdgeListLayout
+	{
+		bool one_based						= false;
+		bool mirror							= false;
+		bool negate_mirror					= false;
+		bool pattern						= false;
+		// Declared matrix size, one based indices past it are rejected
+		size_t rows							= 0;
+		size_t columns						= 0;
+	};
+
+	inline bool isEdgeListSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+	template <class T>
+	const char* parseEdgeListField(const char* first, const char* last, T& value)
+	{
+		while (first != last && isEdgeListSpace(*first))
+			++first;
+		// from_chars doesn't take a leading plus
+		if (first != last && *first == '+')
+			++first;
+		auto [ptr, error] = std::from_chars(first, last, value);
+		if (error != std::errc() || (ptr != last && !isEdgeListSpace(*ptr)))
+			return nullptr;
+		return ptr;
+	}
+
+	// Parses the complete lines in [first, last) into edges
+	template <class Edge, class Weight, bool Weighted>
+	void parseEdgeListLines(const char* first, const char* last, const EdgeListLayout& layout, std::vector<Edge>& edges)
+	{
+		using vertex_type = std::tuple_element_t<0, Edge>;
+
+		while (first != last)
+		{
+			auto line_last = std::find(first, last, '\n');
+			auto search = first;
+			while (search != line_last && isEdgeListSpace(*search))
+				++search;
+
+			if (search != line_last && *search != '#' && *search != '%')
+			{
+				vertex_type from, to;
+				auto weight = Weight(1);
+				search = parseEdgeListField(search, line_last, from);
+				if (search != nullptr)
+					search = parseEdgeListField(search, line_last, to);
+				if constexpr (Weighted)
+					if (search != nullptr && !layout.pattern)
+						search = parseEdgeListField(search, line_last, weight);
+				if (search == nullptr || (layout.one_based && (from < vertex_type(1) || to < vertex_type(1))))
+					throw std::runtime_error("Malformed edge: " + std::string(first, line_last));
+				if (layout.one_based && (size_t(from) > layout.rows || size_t(to) > layout.columns))
+					throw std::runtime_error("Matrix Market entry outside the declared size: " + std::string(first, line_last));
+
+				if (layout.one_based)
+				{
+					from -= vertex_type(1);
+					to -= vertex_type(1);
+				}
+				if constexpr (Weighted)
+				{
+					edges.emplace_back(from, to, weight);
+					if (layout.mirror && from != to)
+						edges.emplace_back(to, from, layout.negate_mirror ? Weight(-weight) : weight);
+				}
+				else
+				{
+					edges.emplace_back(from, to);
+					if (layout.mirror && from != to)
+						edges.emplace_back(to, from);
+				}
+			}
+			first = line_last == last ? last : line_last + 1;
+		}
+	}
+
+	// Reads the banner, comments and size line of a Matrix Market file
+	template <bool Directed>
+	EdgeListLayout readMatrixMarketHeader(std::istream& in)
+	{
+		std::string line;
+		if (!std::getline(in, line))
+			throw std::runtime_error("Missing Matrix Market banner");
+		std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+		char object[32] = {}, format[32] = {}, field[32] = {}, symmetry[32] = {};
+		if (std::sscanf(line.c_str(), "%%%%matrixmarket %31s %31s %31s %31s", object, format, field, symmetry) != 4
+			|| std::string(object) != "matrix" || std::string(format) != "coordinate")
+			throw std::runtime_error("Only Matrix Market coordinate matrices are supported");
+
+		EdgeListLayout layout;
+		layout.one_based = true;
+		std::string field_name(field), symmetry_name(symmetry);
+		if (field_name == "pattern")
+			layout.pattern = true;
+		else if (field_name != "real" && field_name != "integer" && field_name != "double")
+			throw std::runtime_error("Unsupported Matrix Market field " + field_name);
+		if (symmetry_name == "skew-symmetric")
+			layout.negate_mirror = true;
+		else if (symmetry_name != "symmetric" && symmetry_name != "general")
+			throw std::runtime_error("Unsupported Matrix Market symmetry " + symmetry_name);
+		// Undirected graphs store the mirror edge anyway
+		layout.mirror = Directed && symmetry_name != "general";
+
+		while (std::getline(in, line))
+		{
+			auto first = std::find_if_not(line.begin(), line.end(), [](char c) { return isEdgeListSpace(c); });
+			if (first == line.end() || *first == '%')
+				continue;
+
+			size_t rows, columns, entries;
+			auto search = parseEdgeListField(line.data() + (first - line.begin()), line.data() + line.size(), rows);
+			if (search != nullptr)
+				search = parseEdgeListField(search, line.data() + line.size(), columns);
+			if (search != nullptr)
+				search = parseEdgeListField(search, line.data() + line.size(), entries);
+			if (search == nullptr)
+				throw std::runtime_error("Malformed Matrix Market size line");
+			layout.rows = rows;
+			layout.columns = columns;
+			return layout;
+		}
+		throw std::runtime_error("Missing Matrix Market size line");
+	}
+
+	// Reads the stream in chunks of whole lines and hands the edges of every chunk to sink in file order.
+	// With a pool each chunk is split at line boundaries and the pieces are parsed in parallel.
+	template <class Edge, class Weight, bool Weighted, bool Directed, class Pool, class Sink>
+	void readEdgeListChunks(std::istream& in, EdgeListFormat format, Pool& pool, Sink&& sink)
+	{
+		constexpr size_t chunk_size = size_t(1) << 22;
+
+		EdgeListLayout layout;
+		if (format == EdgeListFormat::matrix_market)
+			layout = readMatrixMarketHeader<Directed>(in);
+		if (Weighted && std::is_unsigned<Weight>::value && layout.negate_mirror)
+			throw std::runtime_error("Skew-symmetric matrices need a signed weight type");
+		// An undirected edge can't hold a weight and its negation
+		if (!Directed && layout.negate_mirror)
+			throw std::runtime_error("Skew-symmetric matrices need a directed graph");
+
+		const size_t piece_count = pool.size() == 1 ? 1 : pool.size() * 4;
+		std::vector<std::vector<Edge>> pieces(piece_count);
+		std::vector<const char*> bounds(piece_count + 1);
+
+		std::vector<char> buffer;
+		size_t carry = 0;
+		size_t read_size = chunk_size * pool.size();
+		while (true)
+		{
+			buffer.resize(carry + read_size);
+			in.read(buffer.data() + carry, std::streamsize(read_size));
+			auto end = carry + size_t(in.gcount());
+			bool done = !in;
+
+			// Only whole lines are parsed, the rest is carried into the next chunk
+			auto cut = end;
+			if (!done)
+			{
+				while (cut != 0 && buffer[cut - 1] != '\n')
+					--cut;
+				if (cut == 0)
+				{
+					// A line longer than the chunk
+					carry = end;
+					read_size *= 2;
+					continue;
+				}
+			}
+
+			const char* first = buffer.data();
+			bounds[0] = first;
+			for (size_t piece = 1; piece < piece_count; ++piece)
+			{
+				auto search = std::max(bounds[piece - 1], first + cut * piece / piece_count);
+				while (search != first + cut && search != first && search[-1] != '\n')
+					++search;
+				bounds[piece] = search;
+			}
+			bounds[piece_count] = first + cut;
+
+			pool.parallelFor(piece_count, [&](size_t piece)
+			{
+				pieces[piece].clear();
+				parseEdgeListLines<Edge, Weight, Weighted>(bounds[piece], bounds[piece + 1], layout, pieces[piece]);
+			});
+			for (auto& piece : pieces)
+				sink(piece);
+
+			if (done)
+				break;
+			std::copy(buffer.begin() + cut, buffer.begin() + end, buffer.begin());
+			carry = end - cut;
+		}
+	}
+
+	// ---------------- Reader Helpers
+
+	// Adds every edge of the file to g through the bulk addEdges path. Vertices have to be integers.
+	// The pool is anything with size() and parallelFor(count, task), see ThreadPool.h.
+	template <class G, class Pool>
+	void readEdgeList(std::istream& in, G& g, EdgeListFormat format, Pool& pool)
+	{
+		using edge_type = typename G::edge_type;
+		static_assert(std::is_integral<typename G::vertex_type>::value, "Edge list vertices have to be integers");
+
+		readEdgeListChunks<edge_type, typename G::weight_type, G::weighted, G::directed>(in, format, pool,
+			[&](const std::vector<edge_type>& edges) { g.addEdges(edges.begin(), edges.end()); });
+	}
+
+	template <class G>
+	void readEdgeList(std::istream& in, G& g, EdgeListFormat format = EdgeListFormat::edge_list)
+	{
+		SequentialPool pool;
+		readEdgeList(in, g, format, pool);
+	}
+
+	// Builds a CSR snapshot straight from the file without going through a Graph. Vertices get ids in
+	// order of first appearance and duplicates are dropped, the first edge winning, so the result has the
+	// same vertex ids and the same edges and weights per vertex as freezing a graph filled with the same
+	// file. Edges of a vertex keep the file order, same as with addEdges.
+	template <class Csr, class Pool>
+	Csr readCsrEdgeList(std::istream& in, EdgeListFormat format, Pool& pool)
+	{
+		using vertex_type = typename Csr::vertex_type;
+		using weight_type = typename Csr::weight_type;
+		using size_type = typename Csr::size_type;
+		using edge_type = typename Csr::edge_type;
+		static_assert(std::is_integral<vertex_type>::value, "Edge list vertices have to be integers");
+
+		std::vector<vertex_type, typename Csr::allocator_type> vertices;
+		std::unordered_map<vertex_type, size_type> ids;
+		auto idOf = [&](const vertex_type& vertex)
+		{
+			auto [search, inserted] = ids.emplace(vertex, vertices.size());
+			if (inserted)
+				vertices.push_back(vertex);
+			return search->second;
+		};
+
+		// Directed (from, to) id pairs, both directions for undirected graphs
+		std::vector<std::pair<size_type, size_type>> arcs;
+		std::vector<weight_type> arc_weights;
+		readEdgeListChunks<edge_type, weight_type, Csr::weighted, Csr::directed>(in, format, pool,
+			[&](const std::vector<edge_type>& edges)
+			{
+				for (const auto& edge : edges)
+				{
+					auto from = idOf(std::get<0>(edge));
+					auto to = idOf(std::get<1>(edge));
+					if constexpr (!Csr::directed)
+						arcs.emplace_back(to, from);
+					arcs.emplace_back(from, to);
+					if constexpr (Csr::weighted)
+					{
+						if constexpr (!Csr::directed)
+							arc_weights.push_back(std::get<2>(edge));
+						arc_weights.push_back(std::get<2>(edge));
+					}
+				}
+			});
+
+		// Counting sort by source keeps the file order within every row
+		const auto vertex_count = vertices.size();
+		std::vector<size_type, typename Csr::index_allocator_type> offsets(vertex_count + 1, 0);
+		for (const auto& arc : arcs)
+			++offsets[arc.first + 1];
+		for (size_type i = 0; i < vertex_count; ++i)
+			offsets[i + 1] += offsets[i];
+
+		std::vector<size_type> fill(offsets.begin(), offsets.end() - 1);
+		std::vector<size_type> targets(arcs.size());
+		std::vector<weight_type> target_weights(arc_weights.size());
+		for (size_type arc = 0; arc < arcs.size(); ++arc)
+		{
+			auto slot = fill[arcs[arc].first]++;
+			targets[slot] = arcs[arc].second;
+			if constexpr (Csr::weighted)
+				target_weights[slot] = arc_weights[arc];
+		}
+		arcs = {};
+		arc_weights = {};
+
+		// Drops repeated targets within a row, the first edge wins like in Graph
+		std::vector<size_type> seen(vertex_count, Csr::npos);
+		std::vector<size_type, typename Csr::index_allocator_type> neighbors;
+		std::vector<weight_type, typename Csr::weight_allocator_type> weights;
+		neighbors.reserve(targets.size());
+		if constexpr (Csr::weighted)
+			weights.reserve(targets.size());
+		size_type row_first = 0;
+		for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			auto row_last = offsets[vertex + 1];
+			for (auto slot = row_first; slot != row_last; ++slot)
+			{
+				auto to = targets[slot];
+				if (seen[to] == vertex)
+					continue;
+				seen[to] = vertex;
+				neighbors.push_back(to);
+				if constexpr (Csr::weighted)
+					weights.push_back(target_weights[slot]);
+			}
+			row_first = row_last;
+			offsets[vertex + 1] = neighbors.size();
+		}
+
+		return Csr(std::move(vertices), std::move(offsets), std::move(neighbors), std::move(weights));
+	}
+
+	template <class Csr>
+	Csr readCsrEdgeList(std::istream& in, EdgeListFormat format = EdgeListFormat::edge_list)
+	{
+		SequentialPool pool;
+		return readCsrEdgeList<Csr>(in, format, pool);
+	}
+
+}	// namespace jvn
@@ -0,0 +1,197 @@
+#pragma once
+// For std::...
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace jvn
+{
+
+	// Stats policies for Graph. The graph reports what its hot paths do through static members of the
+	// policy, NoGraphStats compiles them away and CountingGraphStats counts them and forwards them to
+	// optional callbacks. Any type with the same static members can be passed instead.
+
+	enum class GraphEvent
+	{
+		// Value is the number of vertices compared, 1 for hashed graphs
+		vertex_lookup,
+		// Value is the number of edges compared, 1 when the edge index answered
+		edge_lookup,
+		// Value is the size in bytes
+		allocation,
+		// An edge that was already there was added again, value is 1
+		duplicate_edge,
+		// A vertex or edge iterator was dereferenced, value is 1
+		dereference,
+	};
+
+	struct NoGraphStats
+	{
+		static constexpr bool enabled		= false;
+
+		static void vertexLookup(size_t) noexcept {}
+		static void edgeLookup(size_t) noexcept {}
+		static void allocation(size_t) noexcept {}
+		static void duplicateEdge() noexcept {}
+		static void dereference() noexcept {}
+		static void degreeReached(size_t, size_t) noexcept {}
+	};
+
+	struct GraphCounters
+	{
+		std::uint64_t vertex_lookups		= 0;
+		std::uint64_t vertex_probes			= 0;
+		std::uint64_t edge_lookups			= 0;
+		std::uint64_t edge_probes			= 0;
+		std::uint64_t allocations			= 0;
+		std::uint64_t allocated_bytes		= 0;
+		std::uint64_t duplicate_edges		= 0;
+		std::uint64_t dereferences			= 0;
+	};
+
+	// Called for every event while set, context is what was passed along with the callback
+	using GraphTraceCallback				= void (*)(void* context, GraphEvent event, size_t value);
+	// Called whenever the out-degree of a vertex reaches a power of two at or above the minimum, which
+	// reports every hub a logarithmic number of times as it grows
+	using GraphHubCallback					= void (*)(void* context, size_t vertex_id, size_t degree);
+
+	// Counts with relaxed atomics shared by every graph using the same Tag, so counters of different
+	// graph types can be kept apart. Callbacks have to be set while no graph using the Tag is in use.
+	template <class Tag = void>
+	class CountingGraphStats
+	{
+	public:
+		static constexpr bool enabled		= true;
+
+		static void vertexLookup(size_t probes) noexcept
+		{
+			add(s_vertex_lookups, 1);
+			add(s_vertex_probes, probes);
+			trace(GraphEvent::vertex_lookup, probes);
+		}
+		static void edgeLookup(size_t probes) noexcept
+		{
+			add(s_edge_lookups, 1);
+			add(s_edge_probes, probes);
+			trace(GraphEvent::edge_lookup, probes);
+		}
+		static void allocation(size_t bytes) noexcept
+		{
+			add(s_allocations, 1);
+			add(s_allocated_bytes, bytes);
+			trace(GraphEvent::allocation, bytes);
+		}
+		static void duplicateEdge() noexcept
+		{
+			add(s_duplicate_edges, 1);
+			trace(GraphEvent::duplicate_edge, 1);
+		}
+		static void dereference() noexcept
+		{
+			add(s_dereferences, 1);
+			trace(GraphEvent::dereference, 1);
+		}
+		static void degreeReached(size_t vertex_id, size_t degree) noexcept
+		{
+			if (s_hub_callback != nullptr && degree >= s_hub_degree && (degree & (degree - 1)) == 0)
+				s_hub_callback(s_hub_context, vertex_id, degree);
+		}
+
+		static GraphCounters counters() noexcept
+		{
+			GraphCounters counters;
+			counters.vertex_lookups = s_vertex_lookups.load(std::memory_order_relaxed);
+			counters.vertex_probes = s_vertex_probes.load(std::memory_order_relaxed);
+			counters.edge_lookups = s_edge_lookups.load(std::memory_order_relaxed);
+			counters.edge_probes = s_edge_probes.load(std::memory_order_relaxed);
+			counters.allocations = s_allocations.load(std::memory_order_relaxed);
+			counters.allocated_bytes = s_allocated_bytes.load(std::memory_order_relaxed);
+			counters.duplicate_edges = s_duplicate_edges.load(std::memory_order_relaxed);
+			counters.dereferences = s_dereferences.load(std::memory_order_relaxed);
+			return counters;
+		}
+
+		static void reset() noexcept
+		{
+			for (auto counter : { &s_vertex_lookups, &s_vertex_probes, &s_edge_lookups, &s_edge_probes,
+				&s_allocations, &s_allocated_bytes, &s_duplicate_edges, &s_dereferences })
+				counter->store(0, std::memory_order_relaxed);
+		}
+
+		// Passing nullptr removes the callback
+		static void setTraceCallback(GraphTraceCallback callback, void* context = nullptr) noexcept
+		{
+			s_trace_context = context;
+			s_trace_callback = callback;
+		}
+		static void setHubCallback(GraphHubCallback callback, void* context = nullptr, size_t min_degree = 1024) noexcept
+		{
+			s_hub_context = context;
+			s_hub_degree = min_degree;
+			s_hub_callback = callback;
+		}
+	private:
+		static void add(std::atomic<std::uint64_t>& counter, size_t value) noexcept
+		{ counter.fetch_add(value, std::memory_order_relaxed); }
+
+		static void trace(GraphEvent event, size_t value) noexcept
+		{
+			if (s_trace_callback != nullptr)
+				s_trace_callback(s_trace_context, event, value);
+		}
+
+		static inline std::atomic<std::uint64_t> s_vertex_lookups{ 0 };
+		static inline std::atomic<std::uint64_t> s_vertex_probes{ 0 };
+		static inline std::atomic<std::uint64_t> s_edge_lookups{ 0 };
+		static inline std::atomic<std::uint64_t> s_edge_probes{ 0 };
+		static inline std::atomic<std::uint64_t> s_allocations{ 0 };
+		static inline std::atomic<std::uint64_t> s_allocated_bytes{ 0 };
+		static inline std::atomic<std::uint64_t> s_duplicate_edges{ 0 };
+		static inline std::atomic<std::uint64_t> s_dereferences{ 0 };
+
+		static inline GraphTraceCallback s_trace_callback = nullptr;
+		static inline void* s_trace_context = nullptr;
+		static inline GraphHubCallback s_hub_callback = nullptr;
+		static inline void* s_hub_context = nullptr;
+		static inline size_t s_hub_degree = 1024;
+	};
+
+	// Allocator adaptor reporting every allocation of Alloc to Stats. Graph puts it on the standard
+	// containers it owns, the vertex index, the id table and the edge indices, whose allocations it
+	// can't report itself. Everything else, rebinding aside, comes from Alloc.
+	template <class Alloc, class Stats>
+	class StatsAllocator : public Alloc
+	{
+		using traits							= std::allocator_traits<Alloc>;
+	public:
+		using value_type						= typename traits::value_type;
+		using size_type							= typename traits::size_type;
+
+		template <class U>
+		struct rebind
+		{
+			using other = StatsAllocator<typename traits::template rebind_alloc<U>, Stats>;
+		};
+
+		StatsAllocator()						= default;
+		// Converts from anything Alloc converts from, which includes the rebound adaptors
+		template <class Other, std::enable_if_t<std::is_constructible<Alloc, const Other&>::value, int> = 0>
+		StatsAllocator(const Other& other) noexcept
+			:Alloc(other)
+			{}
+
+		value_type* allocate(size_type n)
+		{
+			auto memory = traits::allocate(static_cast<Alloc&>(*this), n);
+			Stats::allocation(n * sizeof(value_type));
+			return memory;
+		}
+
+		friend bool operator==(const StatsAllocator& lhs, const StatsAllocator& rhs) noexcept
+		{ return static_cast<const Alloc&>(lhs) == static_cast<const Alloc&>(rhs); }
+		friend bool operator!=(const StatsAllocator& lhs, const StatsAllocator& rhs) noexcept { return !(lhs == rhs); }
+	};
+
+}	// namespace jvn
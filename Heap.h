@@ -0,0 +1,190 @@
+#pragma once
+// For std::...
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jvn
+{
+
+	// Min heap of (key, value) pairs. Keys are never decreased in place, searches push a new entry
+	// and skip the stale ones when they surface, which is cheaper than tracking heap positions.
+	template <class Key, class Value, size_t Arity = 2>
+		class DAryHeap
+	{
+	public:
+		using key_type						= Key;
+		using value_type					= Value;
+		using entry_type					= std::pair<key_type, value_type>;
+		using size_type						= size_t;
+
+		static_assert(Arity >= 2, "A heap needs at least two children per node");
+
+		bool empty() const noexcept { return m_heap.empty(); }
+		size_type size() const noexcept { return m_heap.size(); }
+		void clear() noexcept { m_heap.clear(); }
+
+		void push(const key_type& key, const value_type& value)
+		{
+			m_heap.emplace_back(key, value);
+			siftUp(m_heap.size() - 1);
+		}
+
+		const entry_type& top() const
+		{
+			if (m_heap.empty())
+				throw std::runtime_error("Heap is empty");
+			return m_heap.front();
+		}
+
+		void pop()
+		{
+			if (m_heap.empty())
+				throw std::runtime_error("Heap is empty");
+			m_heap.front() = std::move(m_heap.back());
+			m_heap.pop_back();
+			if (!m_heap.empty())
+				siftDown(0);
+		}
+	private:
+		void siftUp(size_type pos)
+		{
+			auto entry = std::move(m_heap[pos]);
+			while (pos != 0)
+			{
+				auto parent = (pos - 1) / Arity;
+				if (!(entry.first < m_heap[parent].first))
+					break;
+				m_heap[pos] = std::move(m_heap[parent]);
+				pos = parent;
+			}
+			m_heap[pos] = std::move(entry);
+		}
+
+		void siftDown(size_type pos)
+		{
+			auto entry = std::move(m_heap[pos]);
+			auto size = m_heap.size();
+			while (true)
+			{
+				auto first_child = pos * Arity + 1;
+				if (first_child >= size)
+					break;
+
+				auto last_child = first_child + Arity < size ? first_child + Arity : size;
+				auto min_child = first_child;
+				for (auto child = first_child + 1; child < last_child; ++child)
+					if (m_heap[child].first < m_heap[min_child].first)
+						min_child = child;
+
+				if (!(m_heap[min_child].first < entry.first))
+					break;
+				m_heap[pos] = std::move(m_heap[min_child]);
+				pos = min_child;
+			}
+			m_heap[pos] = std::move(entry);
+		}
+
+		std::vector<entry_type> m_heap;
+	};
+
+	template <class Key, class Value>
+	using BinaryHeap = DAryHeap<Key, Value, 2>;
+
+	// Shallower than the binary heap, so fewer cache misses per pop
+	template <class Key, class Value>
+	using QuadHeap = DAryHeap<Key, Value, 4>;
+
+	// Monotone priority queue for non-negative integer keys, pushed keys may not be smaller than the
+	// last popped one, which always holds for Dijkstra. Entries live in buckets by the highest bit in
+	// which they differ from the last popped key so each entry moves at most once per bit.
+	template <class Key, class Value>
+		class RadixHeap
+	{
+	public:
+		using key_type						= Key;
+		using value_type					= Value;
+		using entry_type					= std::pair<key_type, value_type>;
+		using size_type						= size_t;
+
+		static_assert(std::is_integral<key_type>::value, "Radix heap keys have to be integers");
+
+		bool empty() const noexcept { return m_size == 0; }
+		size_type size() const noexcept { return m_size; }
+		void clear() noexcept
+		{
+			for (auto& bucket : m_buckets)
+				bucket.clear();
+			m_size = 0;
+			m_last = key_type(0);
+		}
+
+		void push(const key_type& key, const value_type& value)
+		{
+			if (key < m_last)
+				throw std::logic_error("Radix heap keys can't be smaller than the last popped key");
+			m_buckets[bucketOf(key)].emplace_back(key, value);
+			++m_size;
+		}
+
+		const entry_type& top()
+		{
+			pull();
+			return m_buckets[0].back();
+		}
+
+		void pop()
+		{
+			pull();
+			m_buckets[0].pop_back();
+			--m_size;
+		}
+	private:
+		using unsigned_key					= std::make_unsigned_t<key_type>;
+
+		static constexpr size_type bucket_count = std::numeric_limits<unsigned_key>::digits + 1;
+
+		static size_type bitWidth(unsigned_key bits) noexcept
+		{
+#if defined(__GNUC__)
+			return bits == 0 ? 0 : std::numeric_limits<unsigned long long>::digits - __builtin_clzll(bits);
+#else
+			size_type width = 0;
+			for (; bits != 0; bits >>= 1)
+				++width;
+			return width;
+#endif
+		}
+
+		size_type bucketOf(const key_type& key) const noexcept { return bitWidth(unsigned_key(key) ^ unsigned_key(m_last)); }
+
+		// Makes the first bucket hold the minimum by redistributing the first non empty bucket
+		void pull()
+		{
+			if (!m_buckets[0].empty())
+				return;
+			if (m_size == 0)
+				throw std::runtime_error("Heap is empty");
+
+			size_type index = 1;
+			while (m_buckets[index].empty())
+				++index;
+
+			auto& bucket = m_buckets[index];
+			m_last = bucket.front().first;
+			for (auto& entry : bucket)
+				if (entry.first < m_last)
+					m_last = entry.first;
+			for (auto& entry : bucket)
+				m_buckets[bucketOf(entry.first)].push_back(std::move(entry));
+			bucket.clear();
+		}
+
+		std::vector<entry_type> m_buckets[bucket_count];
+		size_type m_size					= 0;
+		key_type m_last						= key_type(0);
+	};
+
+}	// namespace jvn
@@ -0,0 +1,333 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Vertices within the depth cap of one source
+	struct HopSet
+	{
+		// Ordered by distance, the source first
+		std::vector<size_t> vertices;
+		// vertices[level_offsets[d]] ... vertices[level_offsets[d + 1] - 1] are at distance d
+		std::vector<size_t> level_offsets;
+
+		size_t levelCount() const noexcept { return level_offsets.empty() ? 0 : level_offsets.size() - 1; }
+	};
+
+	// Adds a vertex reported by a search, vertices arrive level by level
+	inline void appendHopHelper(HopSet& hop_set, size_t vertex, size_t level)
+	{
+		if (hop_set.level_offsets.size() == level)
+			hop_set.level_offsets.push_back(hop_set.vertices.size());
+		hop_set.vertices.push_back(vertex);
+	}
+
+	// Bit parallel BFS from up to 64 sources at once (Then et al., MS-BFS). Every vertex keeps a word with
+	// one bit per source that has seen it, so each edge is scanned once per level for all the searches
+	// standing on its source instead of once per search. Reused between batches the arrays are only
+	// cleared where a search touched them, which keeps small k-hop queries on huge graphs cheap.
+	// Csr is a CsrGraph or anything with the same array accessors, like MappedCsrGraph.
+	class MultiSourceBfsWorkspace
+	{
+	public:
+		using size_type						= size_t;
+		using word_type						= std::uint64_t;
+
+		static constexpr size_type max_sources = 64;
+		static constexpr size_type npos		= size_type(-1);
+
+		MultiSourceBfsWorkspace()												= default;
+		MultiSourceBfsWorkspace(const MultiSourceBfsWorkspace&)					= default;
+		MultiSourceBfsWorkspace& operator=(const MultiSourceBfsWorkspace&)		= default;
+
+		// Searches from sources[0] ... sources[count - 1] following out-edges, search i stops after
+		// max_depths[i] levels. Calls visitor(i, vertex, distance) once for every vertex search i reaches,
+		// level by level, the sources themselves at distance 0.
+		template <class Csr, class Visitor>
+		void search(const Csr& g, const size_type* sources, const size_type* max_depths, size_type count, Visitor&& visitor)
+		{
+			if (count > max_sources)
+				throw std::invalid_argument("At most 64 sources per batch");
+			const auto vertex_count = g.size();
+			for (size_type i = 0; i < count; ++i)
+				if (sources[i] >= vertex_count)
+					throw std::out_of_range("Vertex id out of range");
+			start(vertex_count);
+			// A throwing visitor must not leave bits behind for the next search on this workspace
+			try
+			{
+				searchHelper(g.offsets(), g.neighbors(), sources, max_depths, count, visitor);
+			}
+			catch (...)
+			{
+				finish();
+				throw;
+			}
+			finish();
+		}
+	private:
+		template <class Offsets, class Neighbors, class Visitor>
+		void searchHelper(const Offsets& offsets, const Neighbors& neighbors, const size_type* sources, const size_type* max_depths,
+			size_type count, Visitor& visitor)
+		{
+			for (size_type i = 0; i < count; ++i)
+			{
+				auto source = sources[i];
+				auto bit = word_type(1) << i;
+				if (m_seen[source] == 0)
+					m_touched.push_back(source);
+				if (m_visit[source] == 0)
+					m_frontier.push_back(source);
+				m_seen[source] |= bit;
+				m_visit[source] |= bit;
+				visitor(i, source, size_type(0));
+			}
+
+			for (size_type level = 1; !m_frontier.empty(); ++level)
+			{
+				word_type alive = 0;
+				for (size_type i = 0; i < count; ++i)
+					if (max_depths[i] >= level)
+						alive |= word_type(1) << i;
+				if (alive == 0)
+					break;
+
+				for (auto vertex : m_frontier)
+				{
+					auto bits = m_visit[vertex] & alive;
+					m_visit[vertex] = 0;
+					if (bits == 0)
+						continue;
+					for (auto edge = offsets[vertex]; edge != offsets[vertex + 1]; ++edge)
+					{
+						auto neighbor = neighbors[edge];
+						auto discovered = bits & ~m_seen[neighbor];
+						if (discovered == 0)
+							continue;
+						if (m_seen[neighbor] == 0)
+							m_touched.push_back(neighbor);
+						if (m_next[neighbor] == 0)
+							m_next_frontier.push_back(neighbor);
+						m_seen[neighbor] |= discovered;
+						m_next[neighbor] |= discovered;
+					}
+				}
+
+				for (auto vertex : m_next_frontier)
+					for (auto bits = m_next[vertex]; bits != 0; bits &= bits - 1)
+						visitor(lowestSetBit(bits), vertex, level);
+				// Every visit word of the old frontier was cleared above, so the swapped in array is clean
+				std::swap(m_visit, m_next);
+				std::swap(m_frontier, m_next_frontier);
+				m_next_frontier.clear();
+			}
+		}
+
+		void start(size_type size)
+		{
+			if (m_seen.size() < size)
+			{
+				m_seen.resize(size, 0);
+				m_visit.resize(size, 0);
+				m_next.resize(size, 0);
+			}
+			m_touched.clear();
+			m_frontier.clear();
+			m_next_frontier.clear();
+		}
+
+		// Only the current frontiers can still have visit bits, and only touched vertices seen bits
+		void finish() noexcept
+		{
+			for (auto vertex : m_frontier)
+				m_visit[vertex] = 0;
+			for (auto vertex : m_next_frontier)
+				m_next[vertex] = 0;
+			for (auto vertex : m_touched)
+				m_seen[vertex] = 0;
+		}
+
+		std::vector<word_type> m_seen;
+		std::vector<word_type> m_visit;
+		std::vector<word_type> m_next;
+		std::vector<size_type> m_touched;
+		std::vector<size_type> m_frontier;
+		std::vector<size_type> m_next_frontier;
+	};
+
+	// Hop sets of every source within max_depth hops, in batches of 64 sources
+	template <class Csr>
+	std::vector<HopSet> kHopNeighborhoods(const Csr& g, const std::vector<size_t>& sources, size_t max_depth,
+		MultiSourceBfsWorkspace& workspace)
+	{
+		constexpr auto batch_size = MultiSourceBfsWorkspace::max_sources;
+		std::vector<HopSet> hop_sets(sources.size());
+		const std::vector<size_t> max_depths(std::min(sources.size(), batch_size), max_depth);
+		for (size_t first = 0; first < sources.size(); first += batch_size)
+		{
+			const auto count = std::min(batch_size, sources.size() - first);
+			workspace.search(g, sources.data() + first, max_depths.data(), count,
+				[&](size_t i, size_t vertex, size_t level) { appendHopHelper(hop_sets[first + i], vertex, level); });
+		}
+		for (auto& hop_set : hop_sets)
+			hop_set.level_offsets.push_back(hop_set.vertices.size());
+		return hop_sets;
+	}
+
+	template <class Csr>
+	std::vector<HopSet> kHopNeighborhoods(const Csr& g, const std::vector<size_t>& sources, size_t max_depth = Csr::npos)
+	{
+		MultiSourceBfsWorkspace workspace;
+		return kHopNeighborhoods(g, sources, max_depth, workspace);
+	}
+
+	// Hop distance of every vertex from every source by id, Csr::npos for vertices not reached within
+	// max_depth. Takes a vertex count sized array per source, see kHopNeighborhoods for small searches.
+	template <class Csr>
+	std::vector<std::vector<size_t>> multiSourceDistances(const Csr& g, const std::vector<size_t>& sources, size_t max_depth = Csr::npos)
+	{
+		constexpr auto batch_size = MultiSourceBfsWorkspace::max_sources;
+		MultiSourceBfsWorkspace workspace;
+		std::vector<std::vector<size_t>> distances(sources.size());
+		const std::vector<size_t> max_depths(std::min(sources.size(), batch_size), max_depth);
+		for (size_t first = 0; first < sources.size(); first += batch_size)
+		{
+			const auto count = std::min(batch_size, sources.size() - first);
+			for (size_t i = 0; i < count; ++i)
+				distances[first + i].assign(g.size(), Csr::npos);
+			workspace.search(g, sources.data() + first, max_depths.data(), count,
+				[&](size_t i, size_t vertex, size_t level) { distances[first + i][vertex] = level; });
+		}
+		return distances;
+	}
+
+	// Answers k-hop queries submitted from any thread. Workers take whatever is queued, up to 64 queries,
+	// and run them as one multi-source search, so batches grow with the load without holding back a lone
+	// query. The snapshot has to outlive the queue, the destructor answers the queries still queued.
+	template <class Csr>
+	class KHopQueryQueue
+	{
+	public:
+		using size_type						= size_t;
+
+		explicit KHopQueryQueue(const Csr& g, size_type thread_count = 1)
+			:m_graph(g)
+		{
+			if (thread_count == 0)
+				throw std::invalid_argument("No threads");
+			for (size_type i = 0; i < thread_count; ++i)
+				m_threads.emplace_back([this] { workerLoop(); });
+		}
+		KHopQueryQueue(const KHopQueryQueue&)				= delete;
+		KHopQueryQueue& operator=(const KHopQueryQueue&)	= delete;
+		~KHopQueryQueue()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		// Throws std::out_of_range right away for sources that aren't in the snapshot
+		std::future<HopSet> submit(size_type source, size_type max_depth = Csr::npos)
+		{
+			if (source >= m_graph.size())
+				throw std::out_of_range("Vertex id out of range");
+			Query query{ source, max_depth, std::promise<HopSet>() };
+			auto result = query.result.get_future();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queries.push_back(std::move(query));
+			}
+			m_wake.notify_one();
+			return result;
+		}
+	private:
+		struct Query
+		{
+			size_type source;
+			size_type max_depth;
+			std::promise<HopSet> result;
+		};
+
+		void workerLoop()
+		{
+			MultiSourceBfsWorkspace workspace;
+			std::vector<Query> batch;
+			std::vector<size_type> sources, max_depths;
+			std::vector<HopSet> hop_sets;
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_wake.wait(lock, [this] { return m_stop || !m_queries.empty(); });
+					if (m_queries.empty())
+						return;
+					const auto count = std::min(m_queries.size(), MultiSourceBfsWorkspace::max_sources);
+					for (size_type i = 0; i < count; ++i)
+					{
+						batch.push_back(std::move(m_queries.front()));
+						m_queries.pop_front();
+					}
+				}
+
+				try
+				{
+					sources.clear();
+					max_depths.clear();
+					for (auto& query : batch)
+					{
+						sources.push_back(query.source);
+						max_depths.push_back(query.max_depth);
+					}
+					hop_sets.assign(batch.size(), HopSet());
+					workspace.search(m_graph, sources.data(), max_depths.data(), batch.size(),
+						[&](size_type i, size_type vertex, size_type level) { appendHopHelper(hop_sets[i], vertex, level); });
+					for (size_type i = 0; i < batch.size(); ++i)
+					{
+						hop_sets[i].level_offsets.push_back(hop_sets[i].vertices.size());
+						batch[i].result.set_value(std::move(hop_sets[i]));
+					}
+				}
+				catch (...)
+				{
+					// Queries answered before the failure keep their result
+					for (auto& query : batch)
+					{
+						try
+						{
+							query.result.set_exception(std::current_exception());
+						}
+						catch (const std::future_error&) {}
+					}
+				}
+				batch.clear();
+			}
+		}
+
+		const Csr& m_graph;
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::deque<Query> m_queries;
+		bool m_stop							= false;
+	};
+
+}	// namespace jvn
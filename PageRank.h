@@ -0,0 +1,279 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "CsrGraph.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace jvn
+{
+
+	enum class PageRankDirection
+	{
+		// Every vertex sums the contributions of its in-neighbors, no atomics but directed snapshots need
+		// their in-edges, which costs a transposed copy of the neighbor array
+		pull,
+		// Every vertex adds its contribution to its out-neighbors with atomic adds, works on the edges as
+		// they are stored
+		push,
+	};
+
+	struct PageRankOptions
+	{
+		double damping						= 0.85;
+		// Stops once the L1 norm of the change of the ranks in one iteration drops below this
+		double tolerance					= 1e-6;
+		size_t max_iterations				= 100;
+		PageRankDirection direction			= PageRankDirection::pull;
+	};
+
+	// Kernel Helpers ---------------------------------------------
+
+	// Sum of values[indices[0]] ... values[indices[count - 1]]. Four independent accumulators let the
+	// loads of the gathers overlap instead of waiting on one long chain of additions, with AVX2 they are
+	// the lanes of one hardware gather.
+	template <class Real>
+	inline Real gatherSum(const Real* values, const size_t* indices, size_t count) noexcept
+	{
+		size_t i = 0;
+#ifdef __AVX2__
+		static_assert(sizeof(size_t) == sizeof(long long), "Gathers take 64 bit indices");
+		if constexpr (std::is_same<Real, double>::value)
+		{
+			auto sums = _mm256_setzero_pd();
+			for (; i + 4 <= count; i += 4)
+				sums = _mm256_add_pd(sums, _mm256_i64gather_pd(values,
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i)), sizeof(double)));
+			auto halves = _mm_add_pd(_mm256_castpd256_pd128(sums), _mm256_extractf128_pd(sums, 1));
+			auto sum = _mm_cvtsd_f64(_mm_add_sd(halves, _mm_unpackhi_pd(halves, halves)));
+			for (; i < count; ++i)
+				sum += values[indices[i]];
+			return sum;
+		}
+		else if constexpr (std::is_same<Real, float>::value)
+		{
+			auto sums = _mm_setzero_ps();
+			for (; i + 4 <= count; i += 4)
+				sums = _mm_add_ps(sums, _mm256_i64gather_ps(values,
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i)), sizeof(float)));
+			sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+			auto sum = _mm_cvtss_f32(_mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1)));
+			for (; i < count; ++i)
+				sum += values[indices[i]];
+			return sum;
+		}
+#endif
+		Real sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			sum0 += values[indices[i]];
+			sum1 += values[indices[i + 1]];
+			sum2 += values[indices[i + 2]];
+			sum3 += values[indices[i + 3]];
+		}
+		for (; i < count; ++i)
+			sum0 += values[indices[i]];
+		return (sum0 + sum1) + (sum2 + sum3);
+	}
+
+	// Floating point fetch_add only arrives with C++20
+	template <class Real>
+	inline void atomicAdd(std::atomic<Real>& target, Real value) noexcept
+	{
+		auto current = target.load(std::memory_order_relaxed);
+		while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed));
+	}
+
+	// In-edges of a directed snapshot by counting sort, returns the offsets and the sources
+	template <class Csr>
+	std::tuple<std::vector<size_t>, std::vector<size_t>> transposeHelper(const Csr& g)
+	{
+		const auto vertex_count = g.size();
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+
+		std::vector<size_t> in_offsets(vertex_count + 1, 0);
+		for (auto neighbor : neighbors)
+			++in_offsets[neighbor + 1];
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+			in_offsets[vertex + 1] += in_offsets[vertex];
+
+		std::vector<size_t> in_neighbors(neighbors.size());
+		std::vector<size_t> position(in_offsets.begin(), in_offsets.end() - 1);
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+			for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				in_neighbors[position[neighbors[edge]]++] = vertex;
+		return std::make_tuple(std::move(in_offsets), std::move(in_neighbors));
+	}
+
+	// PageRank ---------------------------------------------
+
+	// Power iteration over a CSR snapshot, random jumps land on a vertex with the probability given by
+	// teleport, which has to sum to 1. The rank of vertices without out-edges is redistributed the same
+	// way. Returns the rank of every vertex by id and the number of iterations run.
+	// Real is float or double, float halves the memory traffic of the rank arrays, the convergence check
+	// is summed in double either way.
+	// Csr is a CsrGraph or anything with the same array accessors, the pool anything with size() and
+	// parallelFor(count, task), see ThreadPool.h.
+	template <class Real, class Csr, class Pool>
+	std::tuple<std::vector<Real>, size_t> pageRank(const Csr& g, const std::vector<Real>& teleport, Pool& pool,
+		const PageRankOptions& options = {})
+	{
+		static_assert(std::is_floating_point<Real>::value, "Ranks have to be floating point");
+		using size_type = size_t;
+
+		const auto vertex_count = g.size();
+		if (teleport.size() != vertex_count)
+			throw std::invalid_argument("Teleport vector doesn't match the vertex count");
+		if (!(options.damping >= 0 && options.damping < 1))
+			throw std::invalid_argument("Damping has to be in [0, 1)");
+		if (vertex_count == 0)
+			return std::make_tuple(std::vector<Real>(), size_type(0));
+
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+		const auto damping = Real(options.damping);
+		const bool pull = options.direction == PageRankDirection::pull;
+
+		// Undirected snapshots store every edge in both directions, so their out-edges are the in-edges
+		std::vector<size_type> in_offsets, in_neighbors;
+		if constexpr (Csr::directed)
+			if (pull)
+				std::tie(in_offsets, in_neighbors) = transposeHelper(g);
+		const size_type* gather_offsets = in_offsets.empty() ? offsets.data() : in_offsets.data();
+		const size_type* gather_neighbors = in_offsets.empty() ? neighbors.data() : in_neighbors.data();
+
+		const size_type task_count = pool.size() * 8;
+		const auto bounds = pull && !in_offsets.empty() ? balancedVertexRanges(in_offsets, task_count)
+			: balancedVertexRanges(offsets, task_count);
+		auto forRanges = [&](auto&& task)
+		{
+			pool.parallelFor(task_count, [&](size_type t) { task(t, bounds[t], bounds[t + 1]); });
+		};
+
+		std::vector<Real> ranks(teleport);
+		std::vector<Real> next(vertex_count);
+		std::vector<Real> contributions(vertex_count);
+		std::vector<Real> inverse_degrees(vertex_count);
+		std::vector<std::atomic<Real>> sums(pull ? 0 : vertex_count);
+		std::vector<double> task_dangling(task_count);
+		std::vector<double> task_errors(task_count);
+
+		for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			auto degree = offsets[vertex + 1] - offsets[vertex];
+			inverse_degrees[vertex] = degree == 0 ? Real(0) : Real(1) / Real(degree);
+		}
+
+		size_type iteration = 0;
+		while (iteration < options.max_iterations)
+		{
+			++iteration;
+
+			// Rank each vertex hands to every neighbor, dangling vertices hand theirs to everyone
+			forRanges([&](size_type t, size_type first, size_type last)
+			{
+				double dangling = 0;
+				const Real* rank = ranks.data();
+				const Real* inverse_degree = inverse_degrees.data();
+				Real* contribution = contributions.data();
+				for (auto vertex = first; vertex < last; ++vertex)
+				{
+					contribution[vertex] = rank[vertex] * inverse_degree[vertex];
+					if (inverse_degree[vertex] == 0)
+						dangling += rank[vertex];
+				}
+				if (!pull)
+					for (auto vertex = first; vertex < last; ++vertex)
+						sums[vertex].store(0, std::memory_order_relaxed);
+				task_dangling[t] = dangling;
+			});
+			double dangling = 0;
+			for (auto value : task_dangling)
+				dangling += value;
+			const auto jump = Real(1 - options.damping + options.damping * dangling);
+
+			if (!pull)
+			{
+				forRanges([&](size_type, size_type first, size_type last)
+				{
+					for (auto vertex = first; vertex < last; ++vertex)
+					{
+						auto contribution = contributions[vertex];
+						for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+							atomicAdd(sums[neighbors[edge]], contribution);
+					}
+				});
+			}
+
+			forRanges([&](size_type t, size_type first, size_type last)
+			{
+				double error = 0;
+				const Real* rank = ranks.data();
+				const Real* jump_to = teleport.data();
+				Real* updated = next.data();
+				if (pull)
+				{
+					const Real* contribution = contributions.data();
+					for (auto vertex = first; vertex < last; ++vertex)
+					{
+						auto sum = gatherSum(contribution, gather_neighbors + gather_offsets[vertex],
+							gather_offsets[vertex + 1] - gather_offsets[vertex]);
+						updated[vertex] = jump * jump_to[vertex] + damping * sum;
+					}
+				}
+				else
+				{
+					for (auto vertex = first; vertex < last; ++vertex)
+						updated[vertex] = jump * jump_to[vertex] + damping * sums[vertex].load(std::memory_order_relaxed);
+				}
+				for (auto vertex = first; vertex < last; ++vertex)
+					error += std::abs(double(updated[vertex]) - double(rank[vertex]));
+				task_errors[t] = error;
+			});
+			std::swap(ranks, next);
+
+			double error = 0;
+			for (auto value : task_errors)
+				error += value;
+			if (error < options.tolerance)
+				break;
+		}
+		return std::make_tuple(std::move(ranks), iteration);
+	}
+
+	// PageRank with uniform random jumps
+	template <class Real = double, class Csr, class Pool>
+	std::tuple<std::vector<Real>, size_t> pageRank(const Csr& g, Pool& pool, const PageRankOptions& options = {})
+	{
+		std::vector<Real> teleport(g.size(), g.size() == 0 ? Real(0) : Real(1) / Real(g.size()));
+		return pageRank<Real>(g, teleport, pool, options);
+	}
+
+	// Personalized PageRank, random jumps go back to one of the sources
+	template <class Real = double, class Csr, class Pool>
+	std::tuple<std::vector<Real>, size_t> personalizedPageRank(const Csr& g, const std::vector<size_t>& sources, Pool& pool,
+		const PageRankOptions& options = {})
+	{
+		if (sources.empty())
+			throw std::invalid_argument("No sources");
+		std::vector<Real> teleport(g.size(), Real(0));
+		for (auto source : sources)
+		{
+			if (source >= g.size())
+				throw std::out_of_range("Vertex id out of range");
+			teleport[source] += Real(1) / Real(sources.size());
+		}
+		return pageRank<Real>(g, teleport, pool, options);
+	}
+
+}	// namespace jvn
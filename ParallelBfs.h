@@ -0,0 +1,173 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Level synchronous, direction optimizing BFS over a CSR snapshot. Returns the hop distance of every
+	// vertex by id, CsrGraph::npos for unreachable ones.
+	// Running top down, every frontier vertex claims its unvisited neighbors through an atomic visited
+	// bitmap. Once the frontier's edges outweigh the unexplored ones the search switches to bottom up,
+	// where each unvisited vertex looks for any parent in the frontier and stops at the first hit. That
+	// needs in-edges, which undirected snapshots have, so directed snapshots stay top down.
+	// Csr is a CsrGraph or anything with the same array accessors, like MappedCsrGraph.
+	// The pool is anything with size() and parallelFor(count, task), see ThreadPool.h.
+	template <class Csr, class Pool>
+	std::vector<size_t> parallelBfs(const Csr& g, size_t source, Pool& pool)
+	{
+		using size_type = size_t;
+		using word_type = std::uint64_t;
+		constexpr size_type npos = Csr::npos;
+		constexpr size_type word_bits = 64;
+		// Switching thresholds from Beamer et al.
+		constexpr size_type alpha = 14;
+		constexpr size_type beta = 24;
+		constexpr bool can_bottom_up = !Csr::directed;
+
+		const auto vertex_count = g.size();
+		if (source >= vertex_count)
+			throw std::out_of_range("Vertex id out of range");
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+
+		std::vector<size_type> levels(vertex_count, npos);
+		const auto word_count = (vertex_count + word_bits - 1) / word_bits;
+		std::vector<std::atomic<word_type>> visited(word_count);
+		for (auto& word : visited)
+			word.store(0, std::memory_order_relaxed);
+
+		// Per task output, merged after every level
+		const size_type task_count = pool.size() * 8;
+		std::vector<std::vector<size_type>> task_frontiers(task_count);
+		std::vector<size_type> task_vertices(task_count);
+		std::vector<size_type> task_edges(task_count);
+
+		std::vector<size_type> frontier{ source };
+		std::vector<word_type> frontier_bits;
+		std::vector<word_type> next_bits;
+		levels[source] = 0;
+		visited[source / word_bits].fetch_or(word_type(1) << (source % word_bits), std::memory_order_relaxed);
+
+		size_type frontier_size = 1;
+		size_type frontier_edges = offsets[source + 1] - offsets[source];
+		size_type unexplored_edges = g.edgeCount() - frontier_edges;
+		bool bottom_up = false;
+
+		for (size_type level = 1; frontier_size != 0; ++level)
+		{
+			if constexpr (can_bottom_up)
+			{
+				if (!bottom_up && frontier_edges > unexplored_edges / alpha)
+				{
+					frontier_bits.assign(word_count, 0);
+					next_bits.assign(word_count, 0);
+					for (auto vertex : frontier)
+						frontier_bits[vertex / word_bits] |= word_type(1) << (vertex % word_bits);
+					bottom_up = true;
+				}
+				else if (bottom_up && frontier_size < vertex_count / beta)
+				{
+					frontier.clear();
+					for (size_type word = 0; word < word_count; ++word)
+						for (auto bits = frontier_bits[word]; bits != 0; bits &= bits - 1)
+							frontier.push_back(word * word_bits + lowestSetBit(bits));
+					bottom_up = false;
+				}
+			}
+
+			if (bottom_up)
+			{
+				// Tasks own whole words so the next frontier and visited words are written by one task each
+				const auto words_per_task = (word_count + task_count - 1) / task_count;
+				pool.parallelFor(task_count, [&](size_type task)
+				{
+					size_type found = 0;
+					size_type found_edges = 0;
+					const auto last_word = std::min(word_count, (task + 1) * words_per_task);
+					for (auto word = task * words_per_task; word < last_word; ++word)
+					{
+						auto unvisited = ~visited[word].load(std::memory_order_relaxed);
+						word_type claimed = 0;
+						for (; unvisited != 0; unvisited &= unvisited - 1)
+						{
+							auto bit = lowestSetBit(unvisited);
+							auto vertex = word * word_bits + bit;
+							if (vertex >= vertex_count)
+								break;
+
+							for (auto edge = offsets[vertex]; edge != offsets[vertex + 1]; ++edge)
+							{
+								auto parent = neighbors[edge];
+								if ((frontier_bits[parent / word_bits] >> (parent % word_bits)) & 1)
+								{
+									levels[vertex] = level;
+									claimed |= word_type(1) << bit;
+									++found;
+									found_edges += offsets[vertex + 1] - offsets[vertex];
+									break;
+								}
+							}
+						}
+						next_bits[word] = claimed;
+						if (claimed != 0)
+							visited[word].fetch_or(claimed, std::memory_order_relaxed);
+					}
+					task_vertices[task] = found;
+					task_edges[task] = found_edges;
+				});
+				std::swap(frontier_bits, next_bits);
+			}
+			else
+			{
+				const auto vertices_per_task = (frontier.size() + task_count - 1) / task_count;
+				pool.parallelFor(task_count, [&](size_type task)
+				{
+					auto& local = task_frontiers[task];
+					local.clear();
+					size_type found_edges = 0;
+					const auto last = std::min(frontier.size(), (task + 1) * vertices_per_task);
+					for (auto i = task * vertices_per_task; i < last; ++i)
+					{
+						auto parent = frontier[i];
+						for (auto edge = offsets[parent]; edge != offsets[parent + 1]; ++edge)
+						{
+							auto vertex = neighbors[edge];
+							auto& word = visited[vertex / word_bits];
+							auto bit = word_type(1) << (vertex % word_bits);
+							// Cheap check first, only the winner of the fetch_or claims the vertex
+							if ((word.load(std::memory_order_relaxed) & bit) || (word.fetch_or(bit, std::memory_order_relaxed) & bit))
+								continue;
+							levels[vertex] = level;
+							local.push_back(vertex);
+							found_edges += offsets[vertex + 1] - offsets[vertex];
+						}
+					}
+					task_vertices[task] = local.size();
+					task_edges[task] = found_edges;
+				});
+
+				frontier.clear();
+				for (auto& local : task_frontiers)
+					frontier.insert(frontier.end(), local.begin(), local.end());
+			}
+
+			frontier_size = 0;
+			frontier_edges = 0;
+			for (size_type task = 0; task < task_count; ++task)
+			{
+				frontier_size += task_vertices[task];
+				frontier_edges += task_edges[task];
+			}
+			unexplored_edges -= std::min(unexplored_edges, frontier_edges);
+		}
+		return levels;
+	}
+
+}	// namespace jvn
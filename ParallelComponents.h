@@ -0,0 +1,130 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "CsrGraph.h"
+#include "UnionFind.h"
+
+namespace jvn
+{
+
+	// Connected components of a CSR snapshot in the style of Afforest (Sutton et al.), weakly connected
+	// ones for directed snapshots. Every vertex points at a smaller id of its component, edges are
+	// linked by lock free hooking of the larger root onto the smaller one and pointer jumping flattens
+	// the trees. Linking only the first few edges of every vertex usually merges the giant component
+	// already, so undirected snapshots skip the remaining edges of its vertices.
+	// Returns the same as Graph::connectedComponents: the number of components and the component of every
+	// vertex by id, numbered in order of their lowest id.
+	// Csr is a CsrGraph or anything with the same array accessors, the pool anything with size() and
+	// parallelFor(count, task), see ThreadPool.h.
+	template <class Csr, class Pool>
+	std::tuple<size_t, std::vector<size_t>> parallelConnectedComponents(const Csr& g, Pool& pool)
+	{
+		using size_type = size_t;
+		constexpr size_type neighbor_rounds = 2;
+		constexpr size_type sample_count = 1024;
+
+		const auto vertex_count = g.size();
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+		const size_type task_count = pool.size() * 8;
+		const auto vertices_per_task = (vertex_count + task_count - 1) / task_count;
+
+		std::vector<std::atomic<size_type>> parents(vertex_count);
+		auto forVertices = [&](auto&& task)
+		{
+			pool.parallelFor(task_count, [&](size_type t)
+			{
+				const auto last = std::min(vertex_count, (t + 1) * vertices_per_task);
+				for (auto vertex = t * vertices_per_task; vertex < last; ++vertex)
+					task(vertex);
+			});
+		};
+
+		// Roots only ever get hooked below a smaller id, so the parent pointers can't form a cycle
+		auto link = [&](size_type u, size_type v)
+		{
+			auto p1 = parents[u].load(std::memory_order_relaxed);
+			auto p2 = parents[v].load(std::memory_order_relaxed);
+			while (p1 != p2)
+			{
+				auto high = std::max(p1, p2);
+				auto low = std::min(p1, p2);
+				auto high_parent = parents[high].load(std::memory_order_relaxed);
+				if (high_parent == low)
+					break;
+				if (high_parent == high && parents[high].compare_exchange_strong(high_parent, low, std::memory_order_relaxed))
+					break;
+				p1 = parents[parents[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+				p2 = parents[low].load(std::memory_order_relaxed);
+			}
+		};
+
+		auto compress = [&](size_type vertex)
+		{
+			auto parent = parents[vertex].load(std::memory_order_relaxed);
+			while (true)
+			{
+				auto grandparent = parents[parent].load(std::memory_order_relaxed);
+				if (grandparent == parent)
+					break;
+				parent = grandparent;
+			}
+			parents[vertex].store(parent, std::memory_order_relaxed);
+		};
+
+		forVertices([&](size_type vertex) { parents[vertex].store(vertex, std::memory_order_relaxed); });
+
+		for (size_type round = 0; round < neighbor_rounds; ++round)
+		{
+			forVertices([&](size_type vertex)
+			{
+				auto edge = offsets[vertex] + round;
+				if (edge < offsets[vertex + 1])
+					link(vertex, neighbors[edge]);
+			});
+			forVertices(compress);
+		}
+
+		// The most frequent root of a sample is most likely the giant component. Its vertices can skip
+		// their remaining edges when every edge is seen from both ends, which only holds for undirected
+		// snapshots.
+		auto skipped = Csr::npos;
+		if constexpr (!Csr::directed)
+		{
+			if (vertex_count != 0)
+			{
+				std::unordered_map<size_type, size_type> frequencies;
+				std::uint64_t state = 0x9e3779b97f4a7c15ull;
+				for (size_type i = 0; i < sample_count; ++i)
+				{
+					// Weyl sequence, good enough to spread the samples
+					state += 0x9e3779b97f4a7c15ull;
+					++frequencies[parents[size_type(state % vertex_count)].load(std::memory_order_relaxed)];
+				}
+				skipped = std::max_element(frequencies.begin(), frequencies.end(),
+					[](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; })->first;
+			}
+		}
+
+		forVertices([&](size_type vertex)
+		{
+			if (parents[vertex].load(std::memory_order_relaxed) == skipped)
+				return;
+			for (auto edge = offsets[vertex] + neighbor_rounds; edge < offsets[vertex + 1]; ++edge)
+				link(vertex, neighbors[edge]);
+		});
+		forVertices(compress);
+
+		std::vector<size_type> components(vertex_count);
+		forVertices([&](size_type vertex) { components[vertex] = parents[vertex].load(std::memory_order_relaxed); });
+		auto count = DisjointSets<size_type>::compactLabels(components);
+		return std::make_tuple(count, std::move(components));
+	}
+
+}	// namespace jvn
@@ -0,0 +1,464 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+#include "Reordering.h"
+#include "Serialization.h"
+
+namespace jvn
+{
+
+	enum class PartitionStrategy
+	{
+		// Owner by a hash of the vertex id, balanced but cuts almost every edge
+		hash,
+		// Contiguous id ranges holding about the same number of vertices plus edges, good after a
+		// locality preserving reordering
+		range,
+		// Linear deterministic greedy: streams the vertices and puts each on the shard holding most of
+		// its neighbors, penalized by how full the shard is
+		ldg,
+		// Fennel: like ldg but with an additive penalty that grows as size^(gamma - 1)
+		fennel,
+	};
+
+	struct PartitionOptions
+	{
+		PartitionStrategy strategy			= PartitionStrategy::fennel;
+		// A shard holds at most (1 + imbalance) * vertex_count / shard_count vertices, streaming only
+		double imbalance					= 0.05;
+		// Fennel exponent
+		double gamma						= 1.5;
+	};
+
+	// One shard of a partitioned snapshot. Local ids start with the owned vertices, followed by the ghosts,
+	// the vertices owned by other shards that owned vertices have edges to. Both ranges are sorted by
+	// global id, which is the id in the partitioned snapshot. Only owned vertices have edges, so every
+	// edge lives on the shard owning its source and undirected cut edges are stored on both sides.
+	template <class V, bool Directed = false, bool Weighted = false, class Weight = int>
+		class GraphShard
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using size_type						= size_t;
+		using csr_type						= CsrGraph<V, Directed, Weighted, std::allocator<V>, Weight>;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+
+		GraphShard()						= default;
+		// Adopts ready made parts, e.g. from a loader. Throws std::invalid_argument if they don't fit together.
+		GraphShard(size_type shard_id, size_type shard_count, size_type global_size, size_type owned_count, csr_type graph,
+			std::vector<size_type> global_ids, std::vector<size_type> ghost_owners)
+			:m_shard_id(shard_id),
+			m_shard_count(shard_count),
+			m_global_size(global_size),
+			m_owned_count(owned_count),
+			m_graph(std::move(graph)),
+			m_global_ids(std::move(global_ids)),
+			m_ghost_owners(std::move(ghost_owners))
+		{
+			const auto local_count = m_graph.size();
+			if (m_shard_id >= m_shard_count)
+				throw std::invalid_argument("Shard id out of range");
+			if (m_owned_count > local_count || m_global_ids.size() != local_count || m_ghost_owners.size() != local_count - m_owned_count)
+				throw std::invalid_argument("Shard tables don't match the graph");
+			if (m_graph.offsets()[m_owned_count] != m_graph.edgeCount())
+				throw std::invalid_argument("Ghost vertices can't have edges");
+			auto sorted = [&](auto first, auto last)
+			{
+				return std::adjacent_find(first, last, [](size_type lhs, size_type rhs) { return lhs >= rhs; }) == last;
+			};
+			if (!sorted(m_global_ids.begin(), m_global_ids.begin() + m_owned_count) || !sorted(m_global_ids.begin() + m_owned_count, m_global_ids.end()))
+				throw std::invalid_argument("Global ids have to be increasing");
+			if (local_count != 0 && std::max(m_owned_count == 0 ? 0 : m_global_ids[m_owned_count - 1],
+				m_owned_count == local_count ? 0 : m_global_ids.back()) >= m_global_size)
+				throw std::invalid_argument("Global id out of range");
+			for (auto owner : m_ghost_owners)
+				if (owner >= m_shard_count || owner == m_shard_id)
+					throw std::invalid_argument("Invalid ghost owner");
+		}
+
+		size_type shardId() const noexcept { return m_shard_id; }
+		size_type shardCount() const noexcept { return m_shard_count; }
+		// Vertex count of the whole partitioned snapshot
+		size_type globalSize() const noexcept { return m_global_size; }
+		size_type ownedCount() const noexcept { return m_owned_count; }
+		size_type ghostCount() const noexcept { return m_graph.size() - m_owned_count; }
+
+		// Owned vertices and ghosts, edges by local id
+		const csr_type& graph() const noexcept { return m_graph; }
+		const std::vector<size_type>& globalIds() const noexcept { return m_global_ids; }
+		// Owner of every ghost, by local id - ownedCount()
+		const std::vector<size_type>& ghostOwners() const noexcept { return m_ghost_owners; }
+
+		constexpr bool isGhost(size_type local_id) const noexcept { return local_id >= m_owned_count; }
+		size_type globalId(size_type local_id) const noexcept { return m_global_ids[local_id]; }
+		size_type owner(size_type local_id) const noexcept { return isGhost(local_id) ? m_ghost_owners[local_id - m_owned_count] : m_shard_id; }
+		// npos if the vertex is neither owned nor a ghost of this shard
+		size_type localId(size_type global_id) const noexcept
+		{
+			auto owned_end = m_global_ids.begin() + m_owned_count;
+			auto search = std::lower_bound(m_global_ids.begin(), owned_end, global_id);
+			if (search == owned_end || *search != global_id)
+			{
+				search = std::lower_bound(owned_end, m_global_ids.end(), global_id);
+				if (search == m_global_ids.end() || *search != global_id)
+					return npos;
+			}
+			return size_type(search - m_global_ids.begin());
+		}
+
+		// Splits local ids, e.g. the next frontier of a BFS, into the global ids of the ghosts among them
+		// grouped by the shard they have to be sent to. Owned vertices are skipped.
+		template <class LocalIds>
+		std::vector<std::vector<size_type>> ghostsByOwner(const LocalIds& local_ids) const
+		{
+			std::vector<std::vector<size_type>> outgoing(m_shard_count);
+			for (size_type local_id : local_ids)
+				if (isGhost(local_id))
+					outgoing[owner(local_id)].push_back(m_global_ids[local_id]);
+			return outgoing;
+		}
+
+		friend void swap(GraphShard& lhs, GraphShard& rhs) noexcept
+		{
+			// Enable ADL
+			using std::swap;
+			swap(lhs.m_shard_id, rhs.m_shard_id);
+			swap(lhs.m_shard_count, rhs.m_shard_count);
+			swap(lhs.m_global_size, rhs.m_global_size);
+			swap(lhs.m_owned_count, rhs.m_owned_count);
+			swap(lhs.m_graph, rhs.m_graph);
+			swap(lhs.m_global_ids, rhs.m_global_ids);
+			swap(lhs.m_ghost_owners, rhs.m_ghost_owners);
+		}
+	private:
+		size_type m_shard_id				= 0;
+		size_type m_shard_count				= 1;
+		size_type m_global_size				= 0;
+		size_type m_owned_count				= 0;
+		csr_type m_graph;
+		std::vector<size_type> m_global_ids;
+		std::vector<size_type> m_ghost_owners;
+	};
+
+	// Partition Helpers ----------------
+
+	// Murmur3 finalizer, spreads consecutive ids over the shards
+	constexpr std::uint64_t mixVertexId(std::uint64_t id) noexcept
+	{
+		id ^= id >> 33;
+		id *= 0xff51afd7ed558ccdull;
+		id ^= id >> 33;
+		id *= 0xc4ceb9fe1a85ec53ull;
+		id ^= id >> 33;
+		return id;
+	}
+
+	// Streams the vertices in id order, scoring every shard by the neighbors already placed on it
+	template <class Csr>
+	std::vector<size_t> streamingPartitionHelper(const Csr& g, size_t shard_count, const PartitionOptions& options)
+	{
+		const auto vertex_count = g.size();
+		const bool fennel = options.strategy == PartitionStrategy::fennel;
+		const auto capacity = std::max<size_t>(1, size_t(std::ceil(double(vertex_count) * (1 + options.imbalance) / double(shard_count))));
+		if (capacity * shard_count < vertex_count)
+			throw std::invalid_argument("Imbalance leaves no room for every vertex");
+
+		// Directed edges pull their endpoints together either way
+		SymmetricAdjacency<Csr> adjacency(g);
+		// Fennel's alpha balances the edge cut against the load for the edge density of the graph
+		const double edge_count = double(Csr::directed ? g.edgeCount() : g.edgeCount() / 2);
+		const double alpha = vertex_count == 0 ? 0 : std::sqrt(double(shard_count)) * edge_count / std::pow(double(vertex_count), 1.5);
+
+		std::vector<size_t> owners(vertex_count, Csr::npos);
+		std::vector<size_t> sizes(shard_count, 0);
+		std::vector<size_t> neighbor_counts(shard_count, 0);
+		std::vector<size_t> touched;
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			for (auto neighbor = adjacency.begin(vertex); neighbor != adjacency.end(vertex); ++neighbor)
+			{
+				auto owner = owners[*neighbor];
+				if (owner != Csr::npos && neighbor_counts[owner]++ == 0)
+					touched.push_back(owner);
+			}
+
+			// Vertices without placed neighbors go to the emptiest shard
+			size_t best = Csr::npos;
+			double best_score = 0;
+			for (size_t shard = 0; shard < shard_count; ++shard)
+			{
+				if (sizes[shard] >= capacity)
+					continue;
+				auto count = double(neighbor_counts[shard]);
+				auto score = fennel ? count - alpha * options.gamma * std::pow(double(sizes[shard]), options.gamma - 1)
+					: count * (1 - double(sizes[shard]) / double(capacity));
+				if (best == Csr::npos || score > best_score || (score == best_score && sizes[shard] < sizes[best]))
+				{
+					best = shard;
+					best_score = score;
+				}
+			}
+			owners[vertex] = best;
+			++sizes[best];
+
+			for (auto shard : touched)
+				neighbor_counts[shard] = 0;
+			touched.clear();
+		}
+		return owners;
+	}
+
+	// ---------------- Partition Helpers
+
+	// Returns the shard owning every vertex of the snapshot by id
+	template <class Csr>
+	std::vector<size_t> partitionVertices(const Csr& g, size_t shard_count, const PartitionOptions& options = {})
+	{
+		if (shard_count == 0)
+			throw std::invalid_argument("No shards");
+		const auto vertex_count = g.size();
+		switch (options.strategy)
+		{
+		case PartitionStrategy::hash:
+		{
+			std::vector<size_t> owners(vertex_count);
+			for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+				owners[vertex] = size_t(mixVertexId(vertex) % shard_count);
+			return owners;
+		}
+		case PartitionStrategy::range:
+		{
+			auto bounds = balancedVertexRanges(g.offsets(), shard_count);
+			std::vector<size_t> owners(vertex_count);
+			for (size_t shard = 0; shard < shard_count; ++shard)
+				std::fill(owners.begin() + bounds[shard], owners.begin() + bounds[shard + 1], shard);
+			return owners;
+		}
+		case PartitionStrategy::ldg:
+		case PartitionStrategy::fennel:
+			return streamingPartitionHelper(g, shard_count, options);
+		}
+		throw std::invalid_argument("Unknown partition strategy");
+	}
+
+	// Number of edges whose endpoints are owned by different shards, undirected edges count twice like
+	// they do in edgeCount()
+	template <class Csr>
+	size_t edgeCut(const Csr& g, const std::vector<size_t>& owners)
+	{
+		if (owners.size() != g.size())
+			throw std::invalid_argument("Owners don't match the vertex count");
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+		size_t cut = 0;
+		for (size_t vertex = 0; vertex < g.size(); ++vertex)
+			for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				cut += owners[vertex] != owners[neighbors[edge]];
+		return cut;
+	}
+
+	// Splits the snapshot into shard_count shards, owners holds the shard of every vertex by id
+	template <class V, bool Directed, bool Weighted, class Alloc, class Weight>
+	std::vector<GraphShard<V, Directed, Weighted, Weight>> makeShards(const CsrGraph<V, Directed, Weighted, Alloc, Weight>& g,
+		const std::vector<size_t>& owners, size_t shard_count)
+	{
+		using shard_type = GraphShard<V, Directed, Weighted, Weight>;
+		using csr_type = typename shard_type::csr_type;
+
+		const auto vertex_count = g.size();
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+		if (owners.size() != vertex_count)
+			throw std::invalid_argument("Owners don't match the vertex count");
+		for (auto owner : owners)
+			if (owner >= shard_count)
+				throw std::invalid_argument("Owner out of range");
+
+		// The local id of every vertex on its own shard, then the ghosts of every shard
+		std::vector<size_t> local_ids(vertex_count);
+		std::vector<std::vector<size_t>> global_ids(shard_count);
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			local_ids[vertex] = global_ids[owners[vertex]].size();
+			global_ids[owners[vertex]].push_back(vertex);
+		}
+		std::vector<std::vector<size_t>> ghosts(shard_count);
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+			for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				if (owners[neighbors[edge]] != owners[vertex])
+					ghosts[owners[vertex]].push_back(neighbors[edge]);
+
+		std::vector<shard_type> shards;
+		shards.reserve(shard_count);
+		for (size_t shard = 0; shard < shard_count; ++shard)
+		{
+			auto& shard_ids = global_ids[shard];
+			auto& shard_ghosts = ghosts[shard];
+			std::sort(shard_ghosts.begin(), shard_ghosts.end());
+			shard_ghosts.erase(std::unique(shard_ghosts.begin(), shard_ghosts.end()), shard_ghosts.end());
+			const auto owned_count = shard_ids.size();
+
+			std::vector<V> vertices;
+			std::vector<size_t> shard_offsets, shard_neighbors, ghost_owners;
+			std::vector<Weight> shard_weights;
+			vertices.reserve(owned_count + shard_ghosts.size());
+			shard_offsets.reserve(owned_count + shard_ghosts.size() + 1);
+			shard_offsets.push_back(0);
+			for (auto vertex : shard_ids)
+			{
+				vertices.push_back(g.vertices()[vertex]);
+				for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				{
+					auto neighbor = neighbors[edge];
+					shard_neighbors.push_back(owners[neighbor] == shard ? local_ids[neighbor] : owned_count
+						+ size_t(std::lower_bound(shard_ghosts.begin(), shard_ghosts.end(), neighbor) - shard_ghosts.begin()));
+					if constexpr (Weighted)
+						shard_weights.push_back(g.weights()[edge]);
+				}
+				shard_offsets.push_back(shard_neighbors.size());
+			}
+			ghost_owners.reserve(shard_ghosts.size());
+			for (auto ghost : shard_ghosts)
+			{
+				vertices.push_back(g.vertices()[ghost]);
+				shard_offsets.push_back(shard_neighbors.size());
+				ghost_owners.push_back(owners[ghost]);
+			}
+			shard_ids.insert(shard_ids.end(), shard_ghosts.begin(), shard_ghosts.end());
+
+			shards.emplace_back(shard, shard_count, vertex_count, owned_count,
+				csr_type(std::move(vertices), std::move(shard_offsets), std::move(shard_neighbors), std::move(shard_weights)),
+				std::move(shard_ids), std::move(ghost_owners));
+		}
+		return shards;
+	}
+
+	// Freezes and partitions the graph, global ids are the ids of the graph
+	template <class V, bool Directed, bool Weighted, class VerEq, class Hash, class Alloc, class Weight, bool InEdges, class Stats>
+	std::vector<GraphShard<V, Directed, Weighted, Weight>> partition(
+		const Graph<V, Directed, Weighted, VerEq, Hash, Alloc, Weight, InEdges, Stats>& g, size_t shard_count, const PartitionOptions& options = {})
+	{
+		auto csr = freeze(g);
+		return makeShards(csr, partitionVertices(csr, shard_count, options), shard_count);
+	}
+
+	// Shard files hold a header, the global id and ghost owner tables and the shard's graph in the
+	// format of saveCsr:
+	//		header | global ids (vertex_count size_t) | ghost owners (vertex_count - owned_count size_t) | CSR file
+	// with the CSR file starting on a csr_file_alignment boundary.
+	struct ShardFileHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t index_size;
+		std::uint64_t shard_id;
+		std::uint64_t shard_count;
+		std::uint64_t global_size;
+		std::uint64_t owned_count;
+		std::uint64_t vertex_count;
+		std::uint64_t graph_pos;
+	};
+
+	inline constexpr char shard_file_magic[8]		= { 'J', 'V', 'N', 'S', 'H', 'R', 'D', '\0' };
+	inline constexpr std::uint32_t shard_file_version	= 1;
+
+	template <class Shard, class Serializer = VertexSerializer<typename Shard::vertex_type>>
+	void saveShard(const Shard& shard, std::ostream& out)
+	{
+		const auto vertex_count = shard.graph().size();
+		ShardFileHeader header{};
+		std::memcpy(header.magic, shard_file_magic, sizeof(header.magic));
+		header.version = shard_file_version;
+		header.index_size = sizeof(size_t);
+		header.shard_id = shard.shardId();
+		header.shard_count = shard.shardCount();
+		header.global_size = shard.globalSize();
+		header.owned_count = shard.ownedCount();
+		header.vertex_count = vertex_count;
+		header.graph_pos = alignCsrSection(sizeof(header) + (2 * vertex_count - shard.ownedCount()) * sizeof(size_t));
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		std::uint64_t pos = sizeof(header);
+		writeCsrArray(out, pos, shard.globalIds().data(), vertex_count);
+		writeCsrArray(out, pos, shard.ghostOwners().data(), shard.ghostCount());
+		writeCsrPadding(out, pos, header.graph_pos);
+		saveCsr<typename Shard::csr_type, Serializer>(shard.graph(), out);
+	}
+
+	template <class Shard, class Serializer = VertexSerializer<typename Shard::vertex_type>>
+	void saveShard(const Shard& shard, const std::string& path)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Can't open " + path);
+		saveShard<Shard, Serializer>(shard, out);
+	}
+
+	// Reads a shard written by saveShard, throws std::runtime_error if the file is damaged
+	template <class Shard, class Serializer = VertexSerializer<typename Shard::vertex_type>>
+	Shard loadShard(std::istream& in)
+	{
+		auto stream_size = csrStreamSize(in);
+		ShardFileHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, shard_file_magic, sizeof(header.magic)) != 0)
+			throw std::runtime_error("Not a shard file");
+		if (header.version != shard_file_version)
+			throw std::runtime_error("Unsupported shard file version");
+		if (header.index_size != sizeof(size_t))
+			throw std::runtime_error("Shard file was written on an incompatible platform");
+		// Guards the position arithmetic against absurd counts
+		if (header.vertex_count > stream_size)
+			throw std::runtime_error("Truncated shard file");
+		if (header.owned_count > header.vertex_count
+			|| header.graph_pos != alignCsrSection(sizeof(header) + (2 * header.vertex_count - header.owned_count) * sizeof(size_t)))
+			throw std::runtime_error("Corrupt shard file header");
+		// The id arrays have to be there before they are allocated, loadCsr checks the graph itself
+		if (header.graph_pos > stream_size)
+			throw std::runtime_error("Truncated shard file");
+		std::uint64_t pos = sizeof(header);
+
+		std::vector<size_t> global_ids, ghost_owners;
+		readCsrArray(in, pos, pos, global_ids, size_t(header.vertex_count));
+		readCsrArray(in, pos, pos, ghost_owners, size_t(header.vertex_count - header.owned_count));
+		in.ignore(std::streamsize(header.graph_pos - pos));
+		auto graph = loadCsr<typename Shard::csr_type, Serializer>(in);
+		if (graph.size() != header.vertex_count)
+			throw std::runtime_error("Corrupt shard file");
+
+		try
+		{
+			return Shard(size_t(header.shard_id), size_t(header.shard_count), size_t(header.global_size), size_t(header.owned_count),
+				std::move(graph), std::move(global_ids), std::move(ghost_owners));
+		}
+		catch (const std::invalid_argument&)
+		{
+			throw std::runtime_error("Corrupt shard file");
+		}
+	}
+
+	template <class Shard, class Serializer = VertexSerializer<typename Shard::vertex_type>>
+	Shard loadShard(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			throw std::runtime_error("Can't open " + path);
+		return loadShard<Shard, Serializer>(in);
+	}
+
+}	// namespace jvn
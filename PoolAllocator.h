@@ -0,0 +1,237 @@
+#pragma once
+// For std::...
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace jvn
+{
+
+	// Arena the pool allocators carve their memory from. Small requests are served from large blocks
+	// and recycled through per size class free lists, bigger or over-aligned ones are forwarded to
+	// operator new and tracked so that release() can free everything in O(blocks).
+	class PoolArena
+	{
+	public:
+		static constexpr size_t alignment		= alignof(std::max_align_t);
+		static constexpr size_t max_pooled_size	= 256;
+
+		explicit PoolArena(size_t block_size) noexcept
+			:m_block_size(block_size < 2 * max_pooled_size ? 2 * max_pooled_size : block_size)
+			{}
+		PoolArena(const PoolArena&)				= delete;
+		PoolArena& operator=(const PoolArena&)	= delete;
+		~PoolArena() { release(); }
+
+		void* allocate(size_t bytes, size_t align = alignment)
+		{
+			if (bytes > max_pooled_size || align > alignment)
+				return allocateLarge(bytes, align);
+
+			auto size_class = sizeClass(bytes);
+			if (auto free_node = m_free_lists[size_class])
+			{
+				m_free_lists[size_class] = free_node->next;
+				return free_node;
+			}
+
+			auto size = (size_class + 1) * alignment;
+			if (m_block_left < size)
+				allocateBlock(m_block_size);
+			auto memory = m_block_cursor;
+			m_block_cursor += size;
+			m_block_left -= size;
+			return memory;
+		}
+
+		void deallocate(void* memory, size_t bytes, size_t align = alignment) noexcept
+		{
+			if (bytes > max_pooled_size || align > alignment)
+				return deallocateLarge(memory);
+
+			auto size_class = sizeClass(bytes);
+			auto free_node = static_cast<FreeNode*>(memory);
+			free_node->next = m_free_lists[size_class];
+			m_free_lists[size_class] = free_node;
+		}
+
+		// Makes sure the next count allocations of the given size don't need a new block
+		void reserve(size_t count, size_t bytes)
+		{
+			if (bytes > max_pooled_size)
+				return;
+			auto size = count * (sizeClass(bytes) + 1) * alignment;
+			if (m_block_left < size)
+				allocateBlock(size + sizeof(BlockHeader) > m_block_size ? size + sizeof(BlockHeader) : m_block_size);
+		}
+
+		// Frees every block and large allocation at once, invalidating all memory handed out so far
+		void release() noexcept
+		{
+			while (m_blocks != nullptr)
+			{
+				auto next = m_blocks->next;
+				::operator delete(m_blocks);
+				m_blocks = next;
+			}
+			while (m_large != nullptr)
+			{
+				auto next = m_large->next;
+				freeLarge(m_large);
+				m_large = next;
+			}
+			for (auto& free_list : m_free_lists)
+				free_list = nullptr;
+			m_block_cursor = nullptr;
+			m_block_left = 0;
+		}
+	private:
+		struct FreeNode
+		{
+			FreeNode* next;
+		};
+
+		struct alignas(std::max_align_t) BlockHeader
+		{
+			BlockHeader* next;
+		};
+
+		// Sits right in front of the memory handed out, which for over-aligned requests isn't the start
+		// of the allocation
+		struct alignas(std::max_align_t) LargeHeader
+		{
+			LargeHeader* prev;
+			LargeHeader* next;
+			void* allocation;
+			size_t align;
+		};
+
+		static constexpr size_t size_class_count = max_pooled_size / alignment;
+
+		static constexpr size_t sizeClass(size_t bytes) noexcept { return bytes == 0 ? 0 : (bytes - 1) / alignment; }
+
+		void allocateBlock(size_t size)
+		{
+			auto block = static_cast<BlockHeader*>(::operator new(size));
+			block->next = m_blocks;
+			m_blocks = block;
+			m_block_cursor = reinterpret_cast<std::byte*>(block) + sizeof(BlockHeader);
+			m_block_left = size - sizeof(BlockHeader);
+		}
+
+		void* allocateLarge(size_t bytes, size_t align)
+		{
+			void* allocation;
+			LargeHeader* large;
+			if (align > alignment)
+			{
+				// The header size rounded up to the alignment, so the memory after it stays aligned
+				auto offset = (sizeof(LargeHeader) + align - 1) / align * align;
+				allocation = ::operator new(offset + bytes, std::align_val_t(align));
+				large = reinterpret_cast<LargeHeader*>(static_cast<std::byte*>(allocation) + offset) - 1;
+			}
+			else
+			{
+				allocation = ::operator new(sizeof(LargeHeader) + bytes);
+				large = static_cast<LargeHeader*>(allocation);
+			}
+			large->allocation = allocation;
+			large->align = align;
+			large->prev = nullptr;
+			large->next = m_large;
+			if (m_large != nullptr)
+				m_large->prev = large;
+			m_large = large;
+			return large + 1;
+		}
+
+		void deallocateLarge(void* memory) noexcept
+		{
+			auto large = static_cast<LargeHeader*>(memory) - 1;
+			if (large->prev != nullptr)
+				large->prev->next = large->next;
+			else
+				m_large = large->next;
+			if (large->next != nullptr)
+				large->next->prev = large->prev;
+			freeLarge(large);
+		}
+
+		static void freeLarge(LargeHeader* large) noexcept
+		{
+			if (large->align > alignment)
+				::operator delete(large->allocation, std::align_val_t(large->align));
+			else
+				::operator delete(large->allocation);
+		}
+
+		size_t m_block_size;
+		BlockHeader* m_blocks					= nullptr;
+		LargeHeader* m_large					= nullptr;
+		std::byte* m_block_cursor				= nullptr;
+		size_t m_block_left						= 0;
+		FreeNode* m_free_lists[size_class_count]	= {};
+	};
+
+	// Slab allocator for graph nodes. Every default constructed allocator owns a fresh arena,
+	// copies and rebinds share it, so the node allocators of a Graph each get their own arena.
+	// Not thread safe, same as the containers it is meant for.
+	template <class T, size_t BlockSize = 64 * 1024>
+		class PoolAllocator
+	{
+	public:
+		using value_type							= T;
+		using size_type								= size_t;
+		using difference_type						= std::ptrdiff_t;
+		using propagate_on_container_copy_assignment	= std::false_type;
+		using propagate_on_container_move_assignment	= std::true_type;
+		using propagate_on_container_swap			= std::true_type;
+		using is_always_equal						= std::false_type;
+
+		template <class U>
+		struct rebind
+		{
+			using other = PoolAllocator<U, BlockSize>;
+		};
+
+		PoolAllocator()
+			:m_arena(std::make_shared<PoolArena>(BlockSize))
+			{}
+		// No move constructor on purpose, a moved from allocator has to stay usable
+		PoolAllocator(const PoolAllocator&) noexcept				= default;
+		PoolAllocator& operator=(const PoolAllocator&) noexcept	= default;
+		template <class U>
+		PoolAllocator(const PoolAllocator<U, BlockSize>& other) noexcept
+			:m_arena(other.m_arena)
+			{}
+
+		// Over-aligned types bypass the blocks but are still tracked by the arena, so release() frees them
+		T* allocate(size_type n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+
+		void deallocate(T* p, size_type n) noexcept { m_arena->deallocate(p, n * sizeof(T), alignof(T)); }
+
+		template <class U, class... Args>
+		void construct(U* p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+		template <class U>
+		void destroy(U* p) { p->~U(); }
+
+		// Preallocates room for n objects so that a bulk load doesn't grow the arena block by block
+		void reserve(size_type n)
+		{
+			if constexpr (alignof(T) <= PoolArena::alignment)
+				m_arena->reserve(n, sizeof(T));
+		}
+
+		// Frees all memory handed out by this allocator and everything sharing its arena
+		void release() noexcept { m_arena->release(); }
+
+		friend bool operator==(const PoolAllocator& lhs, const PoolAllocator& rhs) noexcept { return lhs.m_arena == rhs.m_arena; }
+		friend bool operator!=(const PoolAllocator& lhs, const PoolAllocator& rhs) noexcept { return !(lhs == rhs); }
+
+		template <class, size_t>
+		friend class PoolAllocator;
+	private:
+		std::shared_ptr<PoolArena> m_arena;
+	};
+
+}	// namespace jvn
@@ -0,0 +1,359 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+
+namespace jvn
+{
+
+	// Renumbering passes for CSR snapshots. Every ordering returns a permutation holding the new id of
+	// every vertex by its current id, permute applies it. Per vertex results computed on the renumbered
+	// snapshot map back with original_result[id] = result[permutation[id]].
+	// Directed snapshots are ordered by their edges in both directions.
+	enum class VertexOrder
+	{
+		original,
+		// Descending degree, packs the hubs most traversals keep coming back to
+		degree,
+		// Order of discovery by a breadth first search from every not yet reached vertex
+		bfs,
+		// Reverse Cuthill-McKee, a BFS visiting neighbors by increasing degree, reversed. Keeps the
+		// neighbors of a vertex close to it, good for meshes and road networks.
+		reverse_cuthill_mckee,
+		// Greedy Gorder (Wei et al.), places next the vertex sharing the most edges and common neighbors
+		// with the last few placed ones. Slowest to compute, usually the best locality on social graphs.
+		// See gorderOrder for the parameters.
+		gorder,
+	};
+
+	// Adjacency Helpers ---------------------------------------------
+
+	// Neighbors of a vertex regardless of the edge direction. Undirected snapshots already have both
+	// directions, directed ones get the reverse edges appended to a copy.
+	template <class Csr>
+	class SymmetricAdjacency
+	{
+	public:
+		using size_type						= size_t;
+
+		explicit SymmetricAdjacency(const Csr& g)
+			:m_offsets(g.offsets().data()),
+			m_neighbors(g.neighbors().data())
+		{
+			if constexpr (!Csr::directed)
+				return;
+
+			const auto vertex_count = g.size();
+			const auto& offsets = g.offsets();
+			const auto& neighbors = g.neighbors();
+			m_own_offsets.assign(vertex_count + 1, 0);
+			for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+			{
+				m_own_offsets[vertex + 1] += offsets[vertex + 1] - offsets[vertex];
+				for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+					++m_own_offsets[neighbors[edge] + 1];
+			}
+			for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+				m_own_offsets[vertex + 1] += m_own_offsets[vertex];
+
+			m_own_neighbors.resize(m_own_offsets.back());
+			std::vector<size_type> position(m_own_offsets.begin(), m_own_offsets.end() - 1);
+			for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+				for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				{
+					m_own_neighbors[position[vertex]++] = neighbors[edge];
+					m_own_neighbors[position[neighbors[edge]]++] = vertex;
+				}
+			m_offsets = m_own_offsets.data();
+			m_neighbors = m_own_neighbors.data();
+		}
+
+		size_type degree(size_type vertex) const noexcept { return m_offsets[vertex + 1] - m_offsets[vertex]; }
+		const size_type* begin(size_type vertex) const noexcept { return m_neighbors + m_offsets[vertex]; }
+		const size_type* end(size_type vertex) const noexcept { return m_neighbors + m_offsets[vertex + 1]; }
+	private:
+		const size_type* m_offsets;
+		const size_type* m_neighbors;
+		std::vector<size_type> m_own_offsets;
+		std::vector<size_type> m_own_neighbors;
+	};
+
+	// Turns a sequence of old ids into the new id of every old id
+	inline std::vector<size_t> orderToPermutation(const std::vector<size_t>& order)
+	{
+		std::vector<size_t> permutation(order.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			permutation[order[i]] = i;
+		return permutation;
+	}
+
+	// Orderings ---------------------------------------------
+
+	template <class Csr>
+	std::vector<size_t> degreeOrder(const Csr& g)
+	{
+		SymmetricAdjacency<Csr> adjacency(g);
+		std::vector<size_t> order(g.size());
+		for (size_t vertex = 0; vertex < order.size(); ++vertex)
+			order[vertex] = vertex;
+		// Stable so that vertices of equal degree keep their relative order
+		std::stable_sort(order.begin(), order.end(),
+			[&](size_t lhs, size_t rhs) { return adjacency.degree(lhs) > adjacency.degree(rhs); });
+		return orderToPermutation(order);
+	}
+
+	// Shared by bfs and reverse_cuthill_mckee, which only differ in the start vertices and the order
+	// neighbors are queued in
+	template <class Csr>
+	std::vector<size_t> breadthFirstOrderHelper(const Csr& g, bool by_degree)
+	{
+		SymmetricAdjacency<Csr> adjacency(g);
+		const auto vertex_count = g.size();
+
+		// Cuthill-McKee starts every component at a vertex of minimum degree, an approximation of a
+		// peripheral vertex that keeps the BFS levels narrow
+		std::vector<size_t> starts(vertex_count);
+		for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+			starts[vertex] = vertex;
+		if (by_degree)
+			std::stable_sort(starts.begin(), starts.end(),
+				[&](size_t lhs, size_t rhs) { return adjacency.degree(lhs) < adjacency.degree(rhs); });
+
+		std::vector<size_t> order;
+		order.reserve(vertex_count);
+		std::vector<bool> visited(vertex_count, false);
+		for (auto start : starts)
+		{
+			if (visited[start])
+				continue;
+			visited[start] = true;
+			order.push_back(start);
+			for (auto head = order.size() - 1; head != order.size(); ++head)
+			{
+				auto children = order.size();
+				auto vertex = order[head];
+				for (auto neighbor = adjacency.begin(vertex); neighbor != adjacency.end(vertex); ++neighbor)
+					if (!visited[*neighbor])
+					{
+						visited[*neighbor] = true;
+						order.push_back(*neighbor);
+					}
+				if (by_degree)
+					std::stable_sort(order.begin() + children, order.end(),
+						[&](size_t lhs, size_t rhs) { return adjacency.degree(lhs) < adjacency.degree(rhs); });
+			}
+		}
+		if (by_degree)
+			std::reverse(order.begin(), order.end());
+		return orderToPermutation(order);
+	}
+
+	template <class Csr>
+	std::vector<size_t> bfsOrder(const Csr& g) { return breadthFirstOrderHelper(g, false); }
+
+	template <class Csr>
+	std::vector<size_t> reverseCuthillMcKeeOrder(const Csr& g) { return breadthFirstOrderHelper(g, true); }
+
+	// The window is how many of the last placed vertices a candidate is scored against. Every vertex in
+	// the window adds 1 to each neighbor and to each vertex sharing a neighbor with it. Only neighbors of
+	// at most sibling_degree edges make vertices siblings: everything is close to a hub, and expanding
+	// the hubs costs far more than it gains. That cap is what makes this the lite variant, the paper
+	// expands up to sqrt(size()) and is an order of magnitude slower on skewed graphs.
+	// Scores only ever change by one, so they are kept in buckets of linked lists (the unit heap of the
+	// paper) where every update and extraction is O(1) amortized.
+	template <class Csr>
+	std::vector<size_t> gorderOrder(const Csr& g, size_t window = 5, size_t sibling_degree = 16)
+	{
+		SymmetricAdjacency<Csr> adjacency(g);
+		const auto vertex_count = g.size();
+		if (vertex_count == 0)
+			return {};
+
+		constexpr size_t none = size_t(-1);
+
+		// Bucket lists of the unplaced vertices by score
+		std::vector<size_t> scores(vertex_count, 0);
+		std::vector<size_t> next(vertex_count), previous(vertex_count);
+		std::vector<size_t> buckets(1, none);
+		std::vector<bool> placed(vertex_count, false);
+		size_t top = 0;
+
+		auto unlink = [&](size_t vertex)
+		{
+			if (previous[vertex] == none)
+				buckets[scores[vertex]] = next[vertex];
+			else
+				next[previous[vertex]] = next[vertex];
+			if (next[vertex] != none)
+				previous[next[vertex]] = previous[vertex];
+		};
+		auto link = [&](size_t vertex)
+		{
+			if (scores[vertex] == buckets.size())
+				buckets.push_back(none);
+			previous[vertex] = none;
+			next[vertex] = buckets[scores[vertex]];
+			if (next[vertex] != none)
+				previous[next[vertex]] = vertex;
+			buckets[scores[vertex]] = vertex;
+		};
+		auto adjust = [&](size_t vertex, bool increase)
+		{
+			if (placed[vertex])
+				return;
+			unlink(vertex);
+			if (increase)
+				top = std::max(top, ++scores[vertex]);
+			else
+				--scores[vertex];
+			link(vertex);
+		};
+		// Scores everything close to vertex as it enters or leaves the window
+		auto update = [&](size_t vertex, bool increase)
+		{
+			for (auto neighbor = adjacency.begin(vertex); neighbor != adjacency.end(vertex); ++neighbor)
+			{
+				adjust(*neighbor, increase);
+				if (adjacency.degree(*neighbor) > sibling_degree)
+					continue;
+				for (auto sibling = adjacency.begin(*neighbor); sibling != adjacency.end(*neighbor); ++sibling)
+					if (*sibling != vertex)
+						adjust(*sibling, increase);
+			}
+		};
+
+		// Linked back to front so bucket 0 hands out untouched vertices in id order
+		for (auto vertex = vertex_count; vertex-- > 0;)
+			link(vertex);
+
+		// Starting at the highest degree vertex scores the densest region first
+		size_t start = 0;
+		for (size_t vertex = 1; vertex < vertex_count; ++vertex)
+			if (adjacency.degree(vertex) > adjacency.degree(start))
+				start = vertex;
+
+		std::vector<size_t> order;
+		order.reserve(vertex_count);
+		for (auto vertex = start; ; )
+		{
+			unlink(vertex);
+			placed[vertex] = true;
+			order.push_back(vertex);
+			if (order.size() == vertex_count)
+				break;
+
+			update(vertex, true);
+			if (order.size() > window)
+				update(order[order.size() - 1 - window], false);
+
+			while (buckets[top] == none)
+				--top;
+			vertex = buckets[top];
+		}
+		return orderToPermutation(order);
+	}
+
+	template <class Csr>
+	std::vector<size_t> vertexOrder(const Csr& g, VertexOrder order)
+	{
+		switch (order)
+		{
+		case VertexOrder::original:
+		{
+			std::vector<size_t> permutation(g.size());
+			for (size_t vertex = 0; vertex < permutation.size(); ++vertex)
+				permutation[vertex] = vertex;
+			return permutation;
+		}
+		case VertexOrder::degree:
+			return degreeOrder(g);
+		case VertexOrder::bfs:
+			return bfsOrder(g);
+		case VertexOrder::reverse_cuthill_mckee:
+			return reverseCuthillMcKeeOrder(g);
+		case VertexOrder::gorder:
+			return gorderOrder(g);
+		}
+		throw std::invalid_argument("Unknown vertex order");
+	}
+
+	// Renumbering ---------------------------------------------
+
+	// Copy of the snapshot where vertex id becomes permutation[id]. The edges of every vertex come out
+	// sorted by target so a vertex reads its neighbors front to back in memory too.
+	// Throws std::invalid_argument unless permutation is a permutation of 0 ... size() - 1.
+	template <class V, bool Directed, bool Weighted, class Alloc, class Weight>
+	CsrGraph<V, Directed, Weighted, Alloc, Weight> permute(const CsrGraph<V, Directed, Weighted, Alloc, Weight>& g,
+		const std::vector<size_t>& permutation)
+	{
+		using csr_type = CsrGraph<V, Directed, Weighted, Alloc, Weight>;
+		using size_type = typename csr_type::size_type;
+		const auto vertex_count = g.size();
+
+		if (permutation.size() != vertex_count)
+			throw std::invalid_argument("Permutation doesn't match the vertex count");
+		std::vector<size_type> inverse(vertex_count, csr_type::npos);
+		for (size_type vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			if (permutation[vertex] >= vertex_count || inverse[permutation[vertex]] != csr_type::npos)
+				throw std::invalid_argument("Not a permutation");
+			inverse[permutation[vertex]] = vertex;
+		}
+
+		const auto& offsets = g.offsets();
+		const auto& neighbors = g.neighbors();
+		const auto& weights = g.weights();
+
+		std::vector<V, Alloc> new_vertices(g.vertices().get_allocator());
+		std::vector<size_type, typename csr_type::index_allocator_type> new_offsets(offsets.get_allocator());
+		std::vector<size_type, typename csr_type::index_allocator_type> new_neighbors(neighbors.get_allocator());
+		std::vector<Weight, typename csr_type::weight_allocator_type> new_weights(weights.get_allocator());
+		new_vertices.reserve(vertex_count);
+		new_offsets.reserve(vertex_count + 1);
+		new_neighbors.reserve(neighbors.size());
+		if constexpr (Weighted)
+			new_weights.reserve(weights.size());
+
+		// Sorting edge positions instead of the targets keeps the weights attached
+		std::vector<size_type> row;
+		new_offsets.push_back(0);
+		for (size_type id = 0; id < vertex_count; ++id)
+		{
+			auto vertex = inverse[id];
+			new_vertices.push_back(g.vertices()[vertex]);
+
+			row.clear();
+			for (auto edge = offsets[vertex]; edge < offsets[vertex + 1]; ++edge)
+				row.push_back(edge);
+			std::sort(row.begin(), row.end(),
+				[&](size_type lhs, size_type rhs) { return permutation[neighbors[lhs]] < permutation[neighbors[rhs]]; });
+			for (auto edge : row)
+			{
+				new_neighbors.push_back(permutation[neighbors[edge]]);
+				if constexpr (Weighted)
+					new_weights.push_back(weights[edge]);
+			}
+			new_offsets.push_back(new_neighbors.size());
+		}
+		return csr_type(std::move(new_vertices), std::move(new_offsets), std::move(new_neighbors), std::move(new_weights));
+	}
+
+	// Freezes the graph with renumbered vertices. Returns the snapshot and the permutation holding the
+	// snapshot id of every vertex by its id in the graph.
+	template <class V, bool Directed, bool Weighted, class VerEq, class Hash, class Alloc, class Weight, bool InEdges, class Stats>
+	std::tuple<CsrGraph<V, Directed, Weighted, Alloc, Weight>, std::vector<size_t>> freeze(
+		const Graph<V, Directed, Weighted, VerEq, Hash, Alloc, Weight, InEdges, Stats>& g, VertexOrder order)
+	{
+		auto csr = freeze(g);
+		auto permutation = vertexOrder(csr, order);
+		if (order != VertexOrder::original)
+			csr = permute(csr, permutation);
+		return std::make_tuple(std::move(csr), std::move(permutation));
+	}
+
+}	// namespace jvn
@@ -0,0 +1,514 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CsrGraph.h"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JVN_HAS_MMAP 1
+#endif
+
+namespace jvn
+{
+
+	// Binary format of a CSR snapshot. Every section starts on a csr_file_alignment boundary so a mapped
+	// file can be used in place:
+	//		header | offsets (vertex_count + 1 size_t) | neighbors (edge_count size_t) |
+	//		weights (edge_count weight_type, weighted graphs only) | vertex table
+	// The vertex table holds the vertices themselves when the serializer stores them inline, otherwise one
+	// serializer record per vertex. Its byte length is in the header, so a snapshot can be followed by more
+	// data in the same stream. Files are only readable on machines with the same byte order and size_t.
+	struct CsrFileHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t flags;
+		std::uint32_t byte_order;
+		std::uint32_t index_size;
+		std::uint32_t weight_size;
+		// sizeof(vertex_type) for inline vertex tables, 0 otherwise
+		std::uint32_t vertex_size;
+		std::uint64_t vertex_count;
+		std::uint64_t edge_count;
+		std::uint64_t offsets_pos;
+		std::uint64_t neighbors_pos;
+		std::uint64_t weights_pos;
+		std::uint64_t vertices_pos;
+		std::uint64_t vertices_size;
+	};
+
+	inline constexpr char csr_file_magic[8]			= { 'J', 'V', 'N', 'C', 'S', 'R', '\0', '\0' };
+	inline constexpr std::uint32_t csr_file_version	= 2;
+	inline constexpr std::uint64_t csr_file_alignment	= 64;
+
+	// Decides how vertices are stored. Trivially copyable ones are copied into the file as they are, which
+	// makes them usable straight from a mapping. Other types need a specialization, or a serializer passed
+	// explicitly, with inline_storage = false and
+	//		static void write(std::ostream& out, const V& vertex);
+	//		static V read(const char*& first, const char* last);
+	// where read advances first past the record and throws if it runs into last.
+	template <class V, class = void>
+	struct VertexSerializer
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "No VertexSerializer for this vertex type, specialize it or pass one");
+		static constexpr bool inline_storage = true;
+	};
+
+	// Length prefixed characters
+	template <class Char, class Traits, class A>
+	struct VertexSerializer<std::basic_string<Char, Traits, A>, void>
+	{
+		using vertex_type					= std::basic_string<Char, Traits, A>;
+
+		static_assert(std::is_trivially_copyable<Char>::value, "String characters have to be trivially copyable");
+		static constexpr bool inline_storage = false;
+
+		static void write(std::ostream& out, const vertex_type& vertex)
+		{
+			std::uint64_t length = vertex.size();
+			out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+			out.write(reinterpret_cast<const char*>(vertex.data()), std::streamsize(length * sizeof(Char)));
+		}
+
+		static vertex_type read(const char*& first, const char* last)
+		{
+			std::uint64_t length;
+			if (std::uint64_t(last - first) < sizeof(length))
+				throw std::runtime_error("Truncated vertex record");
+			std::memcpy(&length, first, sizeof(length));
+			first += sizeof(length);
+			if ((std::uint64_t(last - first)) / sizeof(Char) < length)
+				throw std::runtime_error("Truncated vertex record");
+
+			vertex_type vertex;
+			vertex.resize(size_t(length));
+			std::memcpy(vertex.data(), first, size_t(length) * sizeof(Char));
+			first += length * sizeof(Char);
+			return vertex;
+		}
+	};
+
+	// Non owning view of a contiguous array, what the mapped graph hands out instead of vectors
+	template <class T>
+	class ArrayView
+	{
+	public:
+		using value_type					= T;
+		using size_type						= size_t;
+
+		constexpr ArrayView() noexcept		= default;
+		constexpr ArrayView(const T* data, size_type size) noexcept
+			:m_data(data),
+			m_size(size)
+			{}
+
+		constexpr const T& operator[](size_type i) const noexcept { return m_data[i]; }
+		constexpr const T* data() const noexcept { return m_data; }
+		constexpr size_type size() const noexcept { return m_size; }
+		constexpr bool empty() const noexcept { return m_size == 0; }
+		constexpr const T* begin() const noexcept { return m_data; }
+		constexpr const T* end() const noexcept { return m_data + m_size; }
+	private:
+		const T* m_data						= nullptr;
+		size_type m_size					= 0;
+	};
+
+	// Serialization Helpers ----------------
+
+	inline constexpr std::uint32_t csr_flag_directed	= 1 << 0;
+	inline constexpr std::uint32_t csr_flag_weighted	= 1 << 1;
+	inline constexpr std::uint32_t csr_flag_floating	= 1 << 2;
+	inline constexpr std::uint32_t csr_flag_signed		= 1 << 3;
+	inline constexpr std::uint32_t csr_byte_order		= 0x01020304;
+
+	constexpr std::uint64_t alignCsrSection(std::uint64_t pos) noexcept
+	{ return (pos + csr_file_alignment - 1) / csr_file_alignment * csr_file_alignment; }
+
+	// records_size is the byte length of the serializer records and ignored for inline vertex tables
+	template <class V, bool Directed, bool Weighted, class Weight, class Serializer>
+	CsrFileHeader makeCsrHeader(std::uint64_t vertex_count, std::uint64_t edge_count, std::uint64_t records_size = 0)
+	{
+		CsrFileHeader header{};
+		std::memcpy(header.magic, csr_file_magic, sizeof(header.magic));
+		header.version = csr_file_version;
+		header.flags = (Directed ? csr_flag_directed : 0) | (Weighted ? csr_flag_weighted : 0)
+			| (std::is_floating_point<Weight>::value ? csr_flag_floating : 0) | (std::is_signed<Weight>::value ? csr_flag_signed : 0);
+		header.byte_order = csr_byte_order;
+		header.index_size = sizeof(size_t);
+		header.weight_size = sizeof(Weight);
+		header.vertex_size = Serializer::inline_storage ? std::uint32_t(sizeof(V)) : 0;
+		header.vertex_count = vertex_count;
+		header.edge_count = edge_count;
+
+		header.offsets_pos = alignCsrSection(sizeof(CsrFileHeader));
+		header.neighbors_pos = alignCsrSection(header.offsets_pos + (vertex_count + 1) * sizeof(size_t));
+		header.weights_pos = alignCsrSection(header.neighbors_pos + edge_count * sizeof(size_t));
+		header.vertices_pos = alignCsrSection(header.weights_pos + (Weighted ? edge_count * sizeof(Weight) : 0));
+		header.vertices_size = Serializer::inline_storage ? vertex_count * sizeof(V) : records_size;
+		return header;
+	}
+
+	// Throws if the file wasn't written for this graph type or its sections don't fit in file_size
+	template <class V, bool Directed, bool Weighted, class Weight, class Serializer>
+	void checkCsrHeader(const CsrFileHeader& header, std::uint64_t file_size)
+	{
+		if (std::memcmp(header.magic, csr_file_magic, sizeof(header.magic)) != 0)
+			throw std::runtime_error("Not a graph file");
+		if (header.version != csr_file_version)
+			throw std::runtime_error("Unsupported graph file version");
+		if (header.byte_order != csr_byte_order || header.index_size != sizeof(size_t))
+			throw std::runtime_error("Graph file was written on an incompatible platform");
+
+		auto expected = makeCsrHeader<V, Directed, Weighted, Weight, Serializer>(header.vertex_count, header.edge_count, header.vertices_size);
+		if (header.flags != expected.flags || header.weight_size != expected.weight_size || header.vertex_size != expected.vertex_size)
+			throw std::runtime_error("Graph file doesn't match the graph type");
+		// Guards the position arithmetic against absurd counts
+		if (header.vertex_count > file_size || header.edge_count > file_size || header.vertices_size > file_size)
+			throw std::runtime_error("Truncated graph file");
+		if (header.offsets_pos != expected.offsets_pos || header.neighbors_pos != expected.neighbors_pos
+			|| header.weights_pos != expected.weights_pos || header.vertices_pos != expected.vertices_pos
+			|| header.vertices_size != expected.vertices_size)
+			throw std::runtime_error("Corrupt graph file header");
+
+		if (header.vertices_pos + header.vertices_size > file_size)
+			throw std::runtime_error("Truncated graph file");
+	}
+
+	inline void writeCsrPadding(std::ostream& out, std::uint64_t& pos, std::uint64_t target)
+	{
+		static constexpr char zeros[csr_file_alignment] = {};
+		out.write(zeros, std::streamsize(target - pos));
+		pos = target;
+	}
+
+	template <class T>
+	void writeCsrArray(std::ostream& out, std::uint64_t& pos, const T* data, size_t count)
+	{
+		out.write(reinterpret_cast<const char*>(data), std::streamsize(count * sizeof(T)));
+		pos += count * sizeof(T);
+	}
+
+	// Bytes from the current position to the end of the stream, which is left where it was. Unseekable
+	// streams get a bound no count fails, readCsrArray keeps corrupt counts from allocating for them.
+	inline std::uint64_t csrStreamSize(std::istream& in)
+	{
+		std::uint64_t stream_size = std::uint64_t(1) << 48;
+		auto start = in.tellg();
+		if (start != std::istream::pos_type(-1) && in.seekg(0, std::ios::end))
+		{
+			stream_size = std::uint64_t(in.tellg() - start);
+			in.seekg(start);
+		}
+		in.clear();
+		return stream_size;
+	}
+
+	// Bytes readCsrArray reads at once
+	inline constexpr size_t csr_read_chunk			= size_t(1) << 20;
+
+	// Grows the array only as the chunks arrive, so a count the stream can't back fails on a short read
+	// after allocating at most twice what was read
+	template <class T, class A>
+	void readCsrArray(std::istream& in, std::uint64_t& pos, std::uint64_t target, std::vector<T, A>& array, size_t count)
+	{
+		in.ignore(std::streamsize(target - pos));
+		array.clear();
+		while (array.size() != count)
+		{
+			auto size = array.size();
+			auto chunk = std::min(count - size, std::max<size_t>(1, csr_read_chunk / sizeof(T)));
+			if (array.capacity() < size + chunk)
+				array.reserve(std::min(count, std::max(2 * array.capacity(), size + chunk)));
+			array.resize(size + chunk);
+			in.read(reinterpret_cast<char*>(array.data() + size), std::streamsize(chunk * sizeof(T)));
+			if (!in)
+				throw std::runtime_error("Truncated graph file");
+		}
+		pos = target + count * sizeof(T);
+	}
+
+	// ---------------- Serialization Helpers
+
+	// Writes a CSR snapshot, works for CsrGraph and MappedCsrGraph alike
+	template <class Csr, class Serializer = VertexSerializer<typename Csr::vertex_type>>
+	void saveCsr(const Csr& g, std::ostream& out)
+	{
+		using vertex_type = typename Csr::vertex_type;
+		using weight_type = typename Csr::weight_type;
+
+		// The records are buffered since their length goes into the header
+		std::string records;
+		if constexpr (!Serializer::inline_storage)
+		{
+			std::ostringstream record_out;
+			for (const auto& vertex : g.vertices())
+				Serializer::write(record_out, vertex);
+			records = std::move(record_out).str();
+		}
+
+		auto header = makeCsrHeader<vertex_type, Csr::directed, Csr::weighted, weight_type, Serializer>(g.size(), g.edgeCount(), records.size());
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		std::uint64_t pos = sizeof(header);
+
+		writeCsrPadding(out, pos, header.offsets_pos);
+		writeCsrArray(out, pos, g.offsets().data(), g.size() + 1);
+		writeCsrPadding(out, pos, header.neighbors_pos);
+		writeCsrArray(out, pos, g.neighbors().data(), g.edgeCount());
+		writeCsrPadding(out, pos, header.weights_pos);
+		if constexpr (Csr::weighted)
+			writeCsrArray(out, pos, g.weights().data(), g.edgeCount());
+		writeCsrPadding(out, pos, header.vertices_pos);
+
+		if constexpr (Serializer::inline_storage)
+			writeCsrArray(out, pos, g.vertices().data(), g.size());
+		else
+			writeCsrArray(out, pos, records.data(), records.size());
+
+		if (!out)
+			throw std::runtime_error("Failed to write the graph file");
+	}
+
+	template <class Csr, class Serializer = VertexSerializer<typename Csr::vertex_type>>
+	void saveCsr(const Csr& g, const std::string& path)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Can't open " + path);
+		saveCsr<Csr, Serializer>(g, out);
+	}
+
+	// Reads a snapshot written by saveCsr into memory and leaves the stream right after it, the arrays are
+	// checked like any adopted by CsrGraph
+	template <class Csr, class Serializer = VertexSerializer<typename Csr::vertex_type>>
+	Csr loadCsr(std::istream& in)
+	{
+		using vertex_type = typename Csr::vertex_type;
+		using weight_type = typename Csr::weight_type;
+
+		auto stream_size = csrStreamSize(in);
+		CsrFileHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			throw std::runtime_error("Not a graph file");
+		checkCsrHeader<vertex_type, Csr::directed, Csr::weighted, weight_type, Serializer>(header, stream_size);
+		std::uint64_t pos = sizeof(header);
+
+		std::vector<vertex_type, typename Csr::allocator_type> vertices;
+		std::vector<size_t, typename Csr::index_allocator_type> offsets;
+		std::vector<size_t, typename Csr::index_allocator_type> neighbors;
+		std::vector<weight_type, typename Csr::weight_allocator_type> weights;
+		readCsrArray(in, pos, header.offsets_pos, offsets, size_t(header.vertex_count + 1));
+		readCsrArray(in, pos, header.neighbors_pos, neighbors, size_t(header.edge_count));
+		if constexpr (Csr::weighted)
+			readCsrArray(in, pos, header.weights_pos, weights, size_t(header.edge_count));
+
+		if constexpr (Serializer::inline_storage)
+			readCsrArray(in, pos, header.vertices_pos, vertices, size_t(header.vertex_count));
+		else
+		{
+			std::vector<char> records;
+			readCsrArray(in, pos, header.vertices_pos, records, size_t(header.vertices_size));
+			const char* first = records.data();
+			const char* last = first + records.size();
+			vertices.reserve(size_t(header.vertex_count));
+			for (std::uint64_t i = 0; i < header.vertex_count; ++i)
+				vertices.push_back(Serializer::read(first, last));
+			if (first != last)
+				throw std::runtime_error("Corrupt graph file");
+		}
+
+		return Csr(std::move(vertices), std::move(offsets), std::move(neighbors), std::move(weights));
+	}
+
+	template <class Csr, class Serializer = VertexSerializer<typename Csr::vertex_type>>
+	Csr loadCsr(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			throw std::runtime_error("Can't open " + path);
+		return loadCsr<Csr, Serializer>(in);
+	}
+
+#ifdef JVN_HAS_MMAP
+
+	// Read only mapping of a whole file
+	class MappedFile
+	{
+	public:
+		MappedFile()								= default;
+		explicit MappedFile(const std::string& path)
+		{
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error("Can't open " + path);
+			struct stat info;
+			if (::fstat(fd, &info) != 0)
+			{
+				::close(fd);
+				throw std::runtime_error("Can't stat " + path);
+			}
+			m_size = size_t(info.st_size);
+			if (m_size != 0)
+			{
+				auto data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED)
+				{
+					::close(fd);
+					throw std::runtime_error("Can't map " + path);
+				}
+				m_data = static_cast<const char*>(data);
+			}
+			// The mapping stays valid without the descriptor
+			::close(fd);
+		}
+		MappedFile(const MappedFile&)				= delete;
+		MappedFile& operator=(const MappedFile&)	= delete;
+		MappedFile(MappedFile&& file) noexcept
+			:m_data(std::exchange(file.m_data, nullptr)),
+			m_size(std::exchange(file.m_size, 0))
+			{}
+		MappedFile& operator=(MappedFile&& file) noexcept
+		{
+			std::swap(m_data, file.m_data);
+			std::swap(m_size, file.m_size);
+			return *this;
+		}
+		~MappedFile()
+		{
+			if (m_data != nullptr)
+				::munmap(const_cast<char*>(m_data), m_size);
+		}
+
+		const char* data() const noexcept { return m_data; }
+		size_t size() const noexcept { return m_size; }
+	private:
+		const char* m_data					= nullptr;
+		size_t m_size						= 0;
+	};
+
+	// CSR snapshot used straight from a file written by saveCsr. The arrays live in the mapping and are
+	// paged in on first touch, only vertices the serializer doesn't store inline are decoded up front.
+	// Opening checks the header and the section bounds in O(1), verify() additionally checks the arrays
+	// themselves in O(V + E) for files that aren't trusted.
+	// Iterators point at the graph object, moving it invalidates them.
+	template <class V, bool Directed = false, bool Weighted = false, class Weight = int, class Serializer = VertexSerializer<V>>
+		class MappedCsrGraph
+	{
+	public:
+		using vertex_type					= V;
+		using weight_type					= Weight;
+		using edge_type						= std::conditional_t<Weighted,
+											std::tuple<vertex_type, vertex_type, weight_type>,
+											std::tuple<vertex_type, vertex_type>>;
+		using edge_reference				= std::conditional_t<Weighted,
+											std::tuple<const vertex_type&, const vertex_type&, const weight_type&>,
+											std::tuple<const vertex_type&, const vertex_type&>>;
+		using size_type						= size_t;
+
+		static constexpr size_type npos		= size_type(-1);
+		static constexpr bool directed		= Directed;
+		static constexpr bool weighted		= Weighted;
+
+		using vertex_iterator				= CsrVertexIterator<MappedCsrGraph>;
+		using edge_iterator					= CsrEdgeIterator<MappedCsrGraph>;
+
+		explicit MappedCsrGraph(const std::string& path)
+			:m_file(path)
+		{
+			CsrFileHeader header;
+			if (m_file.size() < sizeof(header))
+				throw std::runtime_error("Not a graph file");
+			std::memcpy(&header, m_file.data(), sizeof(header));
+			checkCsrHeader<V, Directed, Weighted, Weight, Serializer>(header, m_file.size());
+
+			m_size = size_type(header.vertex_count);
+			m_offsets = ArrayView<size_type>(sectionAt<size_type>(header.offsets_pos), m_size + 1);
+			m_neighbors = ArrayView<size_type>(sectionAt<size_type>(header.neighbors_pos), size_type(header.edge_count));
+			if constexpr (Weighted)
+				m_weights = ArrayView<weight_type>(sectionAt<weight_type>(header.weights_pos), size_type(header.edge_count));
+			if (m_offsets[0] != 0 || m_offsets[m_size] != m_neighbors.size())
+				throw std::runtime_error("Corrupt graph file");
+
+			if constexpr (Serializer::inline_storage)
+				m_vertices = ArrayView<vertex_type>(sectionAt<vertex_type>(header.vertices_pos), m_size);
+			else
+			{
+				const char* first = m_file.data() + header.vertices_pos;
+				const char* last = first + header.vertices_size;
+				m_decoded.reserve(m_size);
+				for (size_type i = 0; i < m_size; ++i)
+					m_decoded.push_back(Serializer::read(first, last));
+				if (first != last)
+					throw std::runtime_error("Corrupt graph file");
+				m_vertices = ArrayView<vertex_type>(m_decoded.data(), m_size);
+			}
+		}
+		MappedCsrGraph(const MappedCsrGraph&)				= delete;
+		MappedCsrGraph& operator=(const MappedCsrGraph&)	= delete;
+		MappedCsrGraph(MappedCsrGraph&&)					= default;
+		MappedCsrGraph& operator=(MappedCsrGraph&&)			= default;
+
+		// Throws if the offsets decrease or a neighbor id is out of range
+		void verify() const
+		{
+			for (size_type i = 0; i < m_size; ++i)
+				if (m_offsets[i] > m_offsets[i + 1])
+					throw std::runtime_error("Corrupt graph file");
+			for (auto neighbor : m_neighbors)
+				if (neighbor >= m_size)
+					throw std::runtime_error("Corrupt graph file");
+		}
+
+		vertex_iterator begin() const noexcept { return vertex_iterator(this, empty() ? npos : 0); }
+		static constexpr vertex_iterator end() noexcept { return vertex_iterator(nullptr, npos); }
+		static constexpr edge_iterator edge_end() noexcept { return edge_iterator(nullptr, npos, npos); }
+
+		vertex_iterator vertexAt(size_type id) const
+		{
+			if (id >= size())
+				throw std::out_of_range("Vertex id out of range");
+			return vertex_iterator(this, id);
+		}
+
+		size_type size() const noexcept { return m_size; }
+		bool empty() const noexcept { return m_size == 0; }
+		size_type edgeCount() const noexcept { return m_neighbors.size(); }
+		size_type degree(size_type id) const noexcept { return m_offsets[id + 1] - m_offsets[id]; }
+
+		// Same arrays as CsrGraph offers, as views into the mapping
+		ArrayView<vertex_type> vertices() const noexcept { return m_vertices; }
+		ArrayView<size_type> offsets() const noexcept { return m_offsets; }
+		ArrayView<size_type> neighbors() const noexcept { return m_neighbors; }
+		// Empty for unweighted graphs
+		ArrayView<weight_type> weights() const noexcept { return m_weights; }
+	private:
+		template <class T>
+		const T* sectionAt(std::uint64_t pos) const noexcept { return reinterpret_cast<const T*>(m_file.data() + pos); }
+
+		MappedFile m_file;
+		size_type m_size					= 0;
+		ArrayView<vertex_type> m_vertices;
+		ArrayView<size_type> m_offsets;
+		ArrayView<size_type> m_neighbors;
+		ArrayView<weight_type> m_weights;
+		// Backing store of m_vertices when they aren't stored inline
+		std::vector<vertex_type> m_decoded;
+	};
+
+#endif	// JVN_HAS_MMAP
+
+}	// namespace jvn
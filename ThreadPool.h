@@ -0,0 +1,130 @@
+#pragma once
+// For std::...
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jvn
+{
+
+	// Minimal fork join pool used by the parallel algorithms. Any pool can be passed to them instead as
+	// long as it offers size() and parallelFor(count, task), which calls task(i) for every i in [0, count)
+	// and returns once all calls are done. The calling thread works on the tasks too.
+	// parallelFor isn't reentrant, tasks must not submit work to the same pool.
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency())
+		{
+			// The caller counts as one of the threads
+			for (size_t i = 1; i < thread_count; ++i)
+				m_threads.emplace_back([this] { workerLoop(); });
+		}
+		ThreadPool(const ThreadPool&)				= delete;
+		ThreadPool& operator=(const ThreadPool&)	= delete;
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		size_t size() const noexcept { return m_threads.size() + 1; }
+
+		template <class Task>
+		void parallelFor(size_t count, Task&& task)
+		{
+			if (count == 0)
+				return;
+			if (m_threads.empty() || count == 1)
+			{
+				for (size_t i = 0; i < count; ++i)
+					task(i);
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_task = const_cast<void*>(static_cast<const void*>(std::addressof(task)));
+			m_invoke = [](void* task, size_t i) { (*static_cast<std::remove_reference_t<Task>*>(task))(i); };
+			m_count = count;
+			m_next.store(0, std::memory_order_relaxed);
+			m_busy = m_threads.size();
+			m_error = nullptr;
+			++m_generation;
+			lock.unlock();
+			m_wake.notify_all();
+
+			work();
+
+			lock.lock();
+			m_done.wait(lock, [this] { return m_busy == 0; });
+			m_task = nullptr;
+			if (m_error)
+				std::rethrow_exception(std::exchange(m_error, nullptr));
+		}
+	private:
+		void work()
+		{
+			for (size_t i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_count;)
+			{
+				try
+				{
+					m_invoke(m_task, i);
+				}
+				catch (...)
+				{
+					// Keep the first error and skip the remaining tasks
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (!m_error)
+						m_error = std::current_exception();
+					m_next.store(m_count, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void workerLoop()
+		{
+			size_t generation = 0;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+				if (m_stop)
+					return;
+				generation = m_generation;
+
+				lock.unlock();
+				work();
+				lock.lock();
+				if (--m_busy == 0)
+					m_done.notify_one();
+			}
+		}
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		void* m_task						= nullptr;
+		void (*m_invoke)(void*, size_t)		= nullptr;
+		size_t m_count						= 0;
+		std::atomic<size_t> m_next			= 0;
+		size_t m_busy						= 0;
+		size_t m_generation					= 0;
+		std::exception_ptr m_error;
+		bool m_stop							= false;
+	};
+
+}	// namespace jvn
@@ -0,0 +1,100 @@
+#pragma once
+// For std::...
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jvn
+{
+
+	// Disjoint sets over the integers 0 ... size() - 1 with union by rank and path halving, which keeps
+	// both operations at inverse Ackermann amortized cost without a recursive find
+	template <class Index = size_t>
+		class DisjointSets
+	{
+	public:
+		using index_type					= Index;
+		using size_type						= size_t;
+
+		static_assert(std::is_unsigned<index_type>::value, "Disjoint set indices have to be unsigned integers");
+
+		DisjointSets()						= default;
+		explicit DisjointSets(size_type size) { reset(size); }
+
+		// Makes every element its own set again
+		void reset(size_type size)
+		{
+			m_parents.resize(size);
+			m_ranks.assign(size, 0);
+			for (size_type i = 0; i < size; ++i)
+				m_parents[i] = index_type(i);
+			m_count = size;
+		}
+
+		index_type find(index_type x) noexcept
+		{
+			while (m_parents[x] != x)
+			{
+				m_parents[x] = m_parents[m_parents[x]];
+				x = m_parents[x];
+			}
+			return x;
+		}
+
+		// Returns false if both were in the same set already
+		bool unite(index_type x, index_type y) noexcept
+		{
+			x = find(x);
+			y = find(y);
+			if (x == y)
+				return false;
+			if (m_ranks[x] < m_ranks[y])
+				std::swap(x, y);
+			m_parents[y] = x;
+			if (m_ranks[x] == m_ranks[y])
+				++m_ranks[x];
+			--m_count;
+			return true;
+		}
+
+		bool connected(index_type x, index_type y) noexcept { return find(x) == find(y); }
+
+		size_type size() const noexcept { return m_parents.size(); }
+		// Number of disjoint sets
+		size_type count() const noexcept { return m_count; }
+
+		// Returns the number of sets and the set of every element, sets are numbered in order of their
+		// lowest element
+		std::tuple<size_type, std::vector<size_type>> labels()
+		{
+			std::vector<size_type> roots(size());
+			for (size_type i = 0; i < size(); ++i)
+				roots[i] = find(index_type(i));
+			auto count = compactLabels(roots);
+			return std::make_tuple(count, std::move(roots));
+		}
+
+		// Renumbers arbitrary labels to 0 ... count - 1 in order of first appearance, returns count.
+		// Labels have to be smaller than labels.size(), like the roots of a forest over the elements.
+		static size_type compactLabels(std::vector<size_type>& labels)
+		{
+			constexpr size_type unassigned = size_type(-1);
+			std::vector<size_type> renumbered(labels.size(), unassigned);
+			size_type count = 0;
+			for (auto& label : labels)
+			{
+				if (renumbered[label] == unassigned)
+					renumbered[label] = count++;
+				label = renumbered[label];
+			}
+			return count;
+		}
+	private:
+		std::vector<index_type> m_parents;
+		std::vector<unsigned char> m_ranks;
+		size_type m_count					= 0;
+	};
+
+}	// namespace jvn
@@ -0,0 +1,102 @@
+#pragma once
+// For std::...
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace jvn::bench
+{
+
+	using edge_list = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+	// Recursive matrix generator (Chakrabarti et al.) over 2^scale vertices, the Graph500 parameters
+	// give a skewed, community like degree distribution
+	inline edge_list rmat(unsigned scale, std::uint64_t edge_count, std::uint64_t seed,
+		double a = 0.57, double b = 0.19, double c = 0.19)
+	{
+		std::mt19937_64 rng(seed);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		edge_list edges;
+		edges.reserve(edge_count);
+		for (std::uint64_t i = 0; i < edge_count; ++i)
+		{
+			std::uint64_t from = 0, to = 0;
+			for (unsigned bit = 0; bit < scale; ++bit)
+			{
+				auto r = unit(rng);
+				if (r >= a + b + c)
+				{
+					from |= std::uint64_t(1) << bit;
+					to |= std::uint64_t(1) << bit;
+				}
+				else if (r >= a + b)
+					from |= std::uint64_t(1) << bit;
+				else if (r >= a)
+					to |= std::uint64_t(1) << bit;
+			}
+			edges.emplace_back(from, to);
+		}
+		return edges;
+	}
+
+	// G(n, m), endpoints drawn uniformly
+	inline edge_list erdosRenyi(std::uint64_t vertex_count, std::uint64_t edge_count, std::uint64_t seed)
+	{
+		std::mt19937_64 rng(seed);
+		std::uniform_int_distribution<std::uint64_t> vertex(0, vertex_count - 1);
+		edge_list edges;
+		edges.reserve(edge_count);
+		for (std::uint64_t i = 0; i < edge_count; ++i)
+			edges.emplace_back(vertex(rng), vertex(rng));
+		return edges;
+	}
+
+	// rows x columns lattice with edges to the right and lower neighbor, a road network stand in with
+	// high diameter and constant degree
+	inline edge_list grid(std::uint64_t rows, std::uint64_t columns)
+	{
+		edge_list edges;
+		edges.reserve(2 * rows * columns);
+		for (std::uint64_t row = 0; row < rows; ++row)
+			for (std::uint64_t column = 0; column < columns; ++column)
+			{
+				auto vertex = row * columns + column;
+				if (column + 1 < columns)
+					edges.emplace_back(vertex, vertex + 1);
+				if (row + 1 < rows)
+					edges.emplace_back(vertex, vertex + columns);
+			}
+		return edges;
+	}
+
+	// Chung-Lu graph whose expected degrees follow a power law with the given exponent, vertex i gets
+	// weight (i + 1)^(-1 / (exponent - 1))
+	inline edge_list powerLaw(std::uint64_t vertex_count, std::uint64_t edge_count, double exponent, std::uint64_t seed)
+	{
+		std::vector<double> cumulative(vertex_count);
+		double total = 0;
+		for (std::uint64_t i = 0; i < vertex_count; ++i)
+			cumulative[i] = total += std::pow(double(i + 1), -1.0 / (exponent - 1.0));
+
+		std::mt19937_64 rng(seed);
+		std::uniform_real_distribution<double> unit(0.0, total);
+		auto draw = [&]
+		{
+			auto search = std::upper_bound(cumulative.begin(), cumulative.end(), unit(rng));
+			return std::uint64_t(std::min<std::ptrdiff_t>(search - cumulative.begin(), std::ptrdiff_t(vertex_count - 1)));
+		};
+
+		edge_list edges;
+		edges.reserve(edge_count);
+		for (std::uint64_t i = 0; i < edge_count; ++i)
+		{
+			auto from = draw();
+			edges.emplace_back(from, draw());
+		}
+		return edges;
+	}
+
+}	// namespace jvn::bench
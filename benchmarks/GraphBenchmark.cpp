@@ -0,0 +1,1079 @@
+// Benchmarks of the Graph operations on synthetic graphs, every case is timed over a few repetitions and
+// reported with its minimum and median time and the heap footprint of what it built.
+//
+//	g++ -std=c++17 -O2 -DNDEBUG -pthread GraphBenchmark.cpp -o GraphBenchmark
+//	./GraphBenchmark [scale = 14] [repetitions = 5] [filter]
+//
+// Graphs have 2^scale vertices (the grid the nearest square), the filter selects the lines containing it,
+// e.g. "rmat" or "string directed". Generators are seeded so numbers are comparable between runs.
+
+// For std::...
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "../Graph.h"
+#include "../CompressedGraph.h"
+#include "../ConcurrentGraph.h"
+#include "../CsrGraph.h"
+#include "../DeltaGraph.h"
+#include "../DenseGraph.h"
+#include "../GraphReader.h"
+#include "../MultiSourceBfs.h"
+#include "../PageRank.h"
+#include "../ParallelBfs.h"
+#include "../Partition.h"
+#include "../Serialization.h"
+#include "../ThreadPool.h"
+#include "Generators.h"
+
+// Memory Accounting ---------------------------------------------
+
+// Every heap allocation of the process goes through these so a case can report the bytes it keeps alive
+// and its peak. The size is stored in front of the block since sized delete isn't always called.
+namespace
+{
+	std::atomic<std::size_t> g_live_bytes{ 0 };
+	std::atomic<std::size_t> g_peak_bytes{ 0 };
+	constexpr std::size_t header_size = alignof(std::max_align_t);
+
+	void* countedAllocate(std::size_t size)
+	{
+		auto block = static_cast<unsigned char*>(std::malloc(size + header_size));
+		if (block == nullptr)
+			throw std::bad_alloc();
+		*reinterpret_cast<std::size_t*>(block) = size;
+		auto live = g_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+		auto peak = g_peak_bytes.load(std::memory_order_relaxed);
+		while (live > peak && !g_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+		return block + header_size;
+	}
+
+	void countedDeallocate(void* pointer) noexcept
+	{
+		if (pointer == nullptr)
+			return;
+		auto block = static_cast<unsigned char*>(pointer) - header_size;
+		g_live_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+		std::free(block);
+	}
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* pointer) noexcept { countedDeallocate(pointer); }
+void operator delete[](void* pointer) noexcept { countedDeallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { countedDeallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { countedDeallocate(pointer); }
+// Replaced as well since sanitizers intercept them instead of forwarding to the ones above
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedDeallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedDeallocate(pointer); }
+
+namespace
+{
+	// A string the graph keeps out of its vertex nodes, see out_of_line_vertices
+	struct OutOfLineString : std::string
+	{
+		OutOfLineString(std::string value)
+			:std::string(std::move(value))
+			{}
+	};
+}
+
+namespace jvn
+{
+	template <>
+	struct out_of_line_vertices<OutOfLineString> : std::true_type {};
+}
+
+namespace
+{
+	using clock_type = std::chrono::steady_clock;
+
+	// Harness ---------------------------------------------
+
+	// Passed to every case so it can keep its setup out of the measurement
+	class Timer
+	{
+	public:
+		void start()
+		{
+			m_live = g_live_bytes.load(std::memory_order_relaxed);
+			g_peak_bytes.store(m_live, std::memory_order_relaxed);
+			m_start = clock_type::now();
+		}
+		void stop()
+		{
+			m_elapsed = clock_type::now() - m_start;
+			m_retained = std::int64_t(g_live_bytes.load(std::memory_order_relaxed)) - std::int64_t(m_live);
+			m_peak = g_peak_bytes.load(std::memory_order_relaxed) - m_live;
+		}
+
+		clock_type::duration m_elapsed{};
+		// Bytes still allocated at stop, e.g. the graph a case built, and the high water mark in between
+		std::int64_t m_retained = 0;
+		std::size_t m_peak = 0;
+	private:
+		clock_type::time_point m_start;
+		std::size_t m_live = 0;
+	};
+
+	struct Options
+	{
+		unsigned scale = 14;
+		unsigned repetitions = 5;
+		std::string filter;
+	};
+
+	// Keeps results alive so the optimizer can't drop the work producing them
+	volatile std::size_t g_sink = 0;
+
+	template <class Case>
+	void run(const Options& options, const std::string& name, std::size_t items, Case&& bench)
+	{
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+			return;
+
+		std::vector<double> times;
+		Timer timer;
+		for (unsigned i = 0; i < options.repetitions; ++i)
+		{
+			timer = Timer();
+			bench(timer);
+			times.push_back(std::chrono::duration<double, std::milli>(timer.m_elapsed).count());
+		}
+		std::sort(times.begin(), times.end());
+		auto median = times[times.size() / 2];
+		std::printf("%-48s %10.3f %10.3f %10.1f %12.1f %12.1f\n", name.c_str(), times.front(), median,
+			items == 0 ? 0.0 : median * 1e6 / double(items), double(timer.m_retained) / 1024.0, double(timer.m_peak) / 1024.0);
+		std::fflush(stdout);
+	}
+
+	// Checks of what the cases built, they stay on with NDEBUG unlike assert and end the run on a mismatch
+	void check(bool condition, const std::string& name, const char* what)
+	{
+		if (condition)
+			return;
+		std::fprintf(stderr, "%s: %s\n", name.c_str(), what);
+		std::exit(1);
+	}
+
+	// Whether two snapshots hold the same vertices and edges. Vertices are matched by value since the ids
+	// depend on how each snapshot was built, the edges of a vertex are compared as a set.
+	template <class Lhs, class Rhs>
+	bool sameEdges(const Lhs& lhs, const Rhs& rhs, bool compare_weights = true)
+	{
+		if (lhs.size() != rhs.size() || lhs.edgeCount() != rhs.edgeCount())
+			return false;
+		std::unordered_map<typename Rhs::vertex_type, std::size_t> rhs_ids;
+		for (std::size_t id = 0; id < rhs.size(); ++id)
+			rhs_ids.emplace(rhs.vertices()[id], id);
+
+		std::vector<std::tuple<std::size_t, typename Lhs::weight_type>> lhs_row, rhs_row;
+		for (std::size_t id = 0; id < lhs.size(); ++id)
+		{
+			auto search = rhs_ids.find(lhs.vertices()[id]);
+			if (search == rhs_ids.end())
+				return false;
+			auto row = [&](const auto& g, std::size_t vertex, auto&& targetId, auto& edges)
+			{
+				edges.clear();
+				for (auto edge = g.offsets()[vertex]; edge != g.offsets()[vertex + 1]; ++edge)
+				{
+					auto weight = typename Lhs::weight_type(0);
+					if constexpr (std::decay_t<decltype(g)>::weighted)
+						if (compare_weights)
+							weight = g.weights()[edge];
+					edges.emplace_back(targetId(g.neighbors()[edge]), weight);
+				}
+				std::sort(edges.begin(), edges.end());
+			};
+			row(lhs, id, [&](std::size_t target) { return rhs_ids.at(lhs.vertices()[target]); }, lhs_row);
+			row(rhs, search->second, [](std::size_t target) { return target; }, rhs_row);
+			if (lhs_row != rhs_row)
+				return false;
+		}
+		return true;
+	}
+
+	// Whether two snapshots have identical arrays, ids and edge order included
+	template <class Lhs, class Rhs>
+	bool sameArrays(const Lhs& lhs, const Rhs& rhs)
+	{
+		auto equal = [](const auto& a, const auto& b) { return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin()); };
+		return equal(lhs.vertices(), rhs.vertices()) && equal(lhs.offsets(), rhs.offsets())
+			&& equal(lhs.neighbors(), rhs.neighbors()) && equal(lhs.weights(), rhs.weights());
+	}
+
+	template <class Task>
+	bool throws(Task&& task)
+	{
+		try
+		{
+			task();
+		}
+		catch (const std::exception&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	// Reads a string like a pipe, the default seekoff of std::streambuf makes every seek fail
+	class PipeBuffer : public std::streambuf
+	{
+	public:
+		explicit PipeBuffer(std::string& data) { setg(data.data(), data.data(), data.data() + data.size()); }
+	};
+
+	// Inputs ---------------------------------------------
+
+	template <class V>
+	V makeVertex(std::uint64_t id)
+	{
+		if constexpr (std::is_same<V, std::string>::value)
+			// Long enough to defeat the small string buffer, like the keys of most real data sets
+			return "vertex/" + std::to_string(id) + "/0123456789";
+		else
+			return V(id);
+	}
+
+	template <class G>
+	std::vector<typename G::edge_type> makeEdges(const jvn::bench::edge_list& edges, std::uint64_t seed)
+	{
+		using vertex_type = typename G::vertex_type;
+		std::mt19937_64 rng(seed);
+		std::uniform_int_distribution<int> weight(1, 100);
+
+		std::vector<typename G::edge_type> result;
+		result.reserve(edges.size());
+		for (auto [from, to] : edges)
+		{
+			if constexpr (G::weighted)
+				result.emplace_back(makeVertex<vertex_type>(from), makeVertex<vertex_type>(to), typename G::weight_type(weight(rng)));
+			else
+				result.emplace_back(makeVertex<vertex_type>(from), makeVertex<vertex_type>(to));
+		}
+		return result;
+	}
+
+	template <class G>
+	G buildGraph(const std::vector<typename G::edge_type>& edges)
+	{
+		G g;
+		g.addEdges(edges.begin(), edges.end());
+		return g;
+	}
+
+	// Cases ---------------------------------------------
+
+	template <class V, bool Directed, bool Weighted>
+	void benchmarkGraph(const Options& options, const std::string& generator, const jvn::bench::edge_list& input,
+		std::uint64_t vertex_count, jvn::ThreadPool& pool)
+	{
+		using graph_type = jvn::Graph<V, Directed, Weighted>;
+		const std::string prefix = generator + (std::is_same<V, std::string>::value ? " string" : " int")
+			+ (Directed ? " directed" : " undirected") + (Weighted ? " weighted " : " ");
+		// Skip converting the inputs when the filter selects none of the cases
+		if (!options.filter.empty())
+		{
+			bool any = false;
+			for (auto name : { "addVertex", "addEdges", "addEdge reserved", "findEdge hit", "findEdge miss", "iterate", "copy",
+				"addEdges out of line", "iterate out of line",
+				"concurrent addEdge", "readEdgeList", "readCsrEdgeList", "dense addEdges", "dense findEdge hit", "dense removeEdge", "delta addEdges",
+				"delta compact", "removeEdge", "bfs", "shortestPaths", "components", "freeze", "compress", "iterate compressed",
+				"saveCsr", "loadCsr", "mapCsr", "partition", "saveShard", "parallelBfs", "kHop", "pageRank" })
+				any = any || (prefix + name).find(options.filter) != std::string::npos;
+			if (!any)
+				return;
+		}
+
+		using csr_type = jvn::CsrGraph<V, Directed, Weighted>;
+		const auto edges = makeEdges<graph_type>(input, 42);
+		std::vector<typename graph_type::edge_type> misses;
+		{
+			// Uniform pairs, almost all of them absent from the sparse generated graphs
+			auto pairs = jvn::bench::erdosRenyi(vertex_count, input.size(), 7);
+			misses = makeEdges<graph_type>(pairs, 7);
+		}
+		std::vector<V> vertices;
+		for (std::uint64_t i = 0; i < vertex_count; ++i)
+			vertices.push_back(makeVertex<V>(i));
+
+		run(options, prefix + "addVertex", vertices.size(), [&](Timer& timer)
+		{
+			timer.start();
+			graph_type g;
+			for (auto& vertex : vertices)
+				g.addVertex(vertex);
+			timer.stop();
+		});
+
+		run(options, prefix + "addEdge", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			graph_type g;
+			for (auto& edge : edges)
+				g.addEdge(edge);
+			timer.stop();
+		});
+
+		run(options, prefix + "addEdges", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			graph_type g;
+			g.addEdges(edges.begin(), edges.end());
+			timer.stop();
+		});
+
+		run(options, prefix + "addEdge reserved", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			graph_type g(vertices.size(), edges.size());
+			for (auto& edge : edges)
+				g.addEdge(edge);
+			timer.stop();
+		});
+
+		const auto g = buildGraph<graph_type>(edges);
+		if (options.filter.empty() || (prefix + "addEdges").find(options.filter) != std::string::npos)
+		{
+			// The bulk path has to leave every edge list exactly as repeated addEdge does, order included
+			graph_type expected;
+			for (auto& edge : edges)
+				expected.addEdge(edge);
+			const auto lhs = jvn::freeze(g);
+			const auto rhs = jvn::freeze(expected);
+			check(lhs.vertices() == rhs.vertices() && lhs.offsets() == rhs.offsets() && lhs.neighbors() == rhs.neighbors()
+				&& lhs.weights() == rhs.weights(), prefix + "addEdges", "edge lists differ from addEdge");
+		}
+
+		run(options, prefix + "findEdge hit", edges.size(), [&](Timer& timer)
+		{
+			std::size_t found = 0;
+			timer.start();
+			for (auto& edge : edges)
+				found += g.findEdge(edge) != g.edge_end();
+			timer.stop();
+			g_sink = found;
+		});
+
+		run(options, prefix + "findEdge miss", misses.size(), [&](Timer& timer)
+		{
+			std::size_t found = 0;
+			timer.start();
+			for (auto& edge : misses)
+				found += g.findEdge(edge) != g.edge_end();
+			timer.stop();
+			g_sink = found;
+		});
+
+		run(options, prefix + "iterate", edges.size(), [&](Timer& timer)
+		{
+			std::size_t count = 0;
+			timer.start();
+			for (auto vertex = g.begin(); vertex != g.end(); ++vertex)
+				for (auto edge = vertex.getEdges(); edge != g.edge_end(); ++edge)
+					count += edge.getEndVertex().getId();
+			timer.stop();
+			g_sink = count;
+		});
+
+		run(options, prefix + "copy", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			graph_type copy(g);
+			timer.stop();
+		});
+
+		// The same string graph with its vertices in the vertex pool, which takes them out of the nodes a
+		// traversal walks. Removals, re-adds, copies and moves have to keep it equal to the plain graph.
+		if constexpr (std::is_same<V, std::string>::value)
+		{
+			using out_of_line_type = jvn::Graph<OutOfLineString, Directed, Weighted, std::equal_to<OutOfLineString>, std::hash<std::string>>;
+			static_assert(out_of_line_type::out_of_line, "OutOfLineString has to be stored out of line");
+			std::vector<typename out_of_line_type::edge_type> out_of_line_edges(edges.begin(), edges.end());
+			run(options, prefix + "addEdges out of line", edges.size(), [&](Timer& timer)
+			{
+				timer.start();
+				out_of_line_type out_of_line;
+				out_of_line.addEdges(out_of_line_edges.begin(), out_of_line_edges.end());
+				timer.stop();
+			});
+
+			const auto out_of_line = buildGraph<out_of_line_type>(out_of_line_edges);
+			run(options, prefix + "iterate out of line", edges.size(), [&](Timer& timer)
+			{
+				std::size_t count = 0;
+				timer.start();
+				for (auto vertex = out_of_line.begin(); vertex != out_of_line.end(); ++vertex)
+					for (auto edge = vertex.getEdges(); edge != out_of_line.edge_end(); ++edge)
+						count += edge.getEndVertex().getId();
+				timer.stop();
+				g_sink = count;
+			});
+
+			if (options.filter.empty() || (prefix + "addEdges out of line").find(options.filter) != std::string::npos)
+			{
+				const auto name = prefix + "addEdges out of line";
+				check(sameEdges(jvn::freeze(out_of_line), jvn::freeze(g)), name, "edges differ from the plain graph");
+
+				// removeVertex needs the in-edges of directed graphs
+				using removable_type = jvn::Graph<OutOfLineString, Directed, Weighted, std::equal_to<OutOfLineString>, std::hash<std::string>,
+					std::allocator<OutOfLineString>, int, Directed>;
+				using expected_type = jvn::Graph<V, Directed, Weighted, std::equal_to<V>, jvn::default_vertex_hash_t<V>, std::allocator<V>, int, Directed>;
+				const auto removable = buildGraph<removable_type>(out_of_line_edges);
+				removable_type copy(removable);
+				auto expected = buildGraph<expected_type>(edges);
+				check(sameEdges(jvn::freeze(copy), jvn::freeze(expected)), name, "copy differs from the plain graph");
+				for (std::size_t i = 0; i < vertices.size(); i += 3)
+					check(copy.removeVertex(vertices[i]) == expected.removeVertex(vertices[i]), name, "removeVertex result differs");
+				check(copy.size() == expected.size() && sameEdges(jvn::freeze(copy), jvn::freeze(expected)), name,
+					"edges differ after removeVertex");
+				// Re-adding takes the freed pool slots
+				for (std::size_t i = 0; i < edges.size(); i += 5)
+				{
+					copy.addEdge(out_of_line_edges[i]);
+					expected.addEdge(edges[i]);
+				}
+				check(copy.size() == expected.size() && sameEdges(jvn::freeze(copy), jvn::freeze(expected)), name,
+					"edges differ after re-adding");
+
+				removable_type moved(std::move(copy));
+				check(copy.empty() && sameEdges(jvn::freeze(moved), jvn::freeze(expected)), name, "move construction lost edges");
+				copy = removable;
+				swap(copy, moved);
+				check(sameEdges(jvn::freeze(copy), jvn::freeze(expected)) && sameEdges(jvn::freeze(moved), jvn::freeze(g)), name,
+					"copy assignment or swap lost edges");
+				moved = std::move(copy);
+				check(sameEdges(jvn::freeze(moved), jvn::freeze(expected)), name, "move assignment lost edges");
+			}
+		}
+
+		// Every thread takes every thread_count-th edge, the frozen result has to match the graph. Which of
+		// several duplicates with different weights wins depends on the threads, so weights aren't compared.
+		using concurrent_type = jvn::ConcurrentGraph<V, Directed, Weighted>;
+		auto ingest = [&](concurrent_type& concurrent)
+		{
+			const auto thread_count = pool.size();
+			pool.parallelFor(thread_count, [&](std::size_t thread)
+			{
+				for (auto i = thread; i < edges.size(); i += thread_count)
+					concurrent.addEdge(edges[i]);
+			});
+		};
+		run(options, prefix + "concurrent addEdge", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			concurrent_type concurrent;
+			ingest(concurrent);
+			timer.stop();
+			g_sink = concurrent.edgeCount();
+		});
+		if (options.filter.empty() || (prefix + "concurrent addEdge").find(options.filter) != std::string::npos)
+		{
+			concurrent_type concurrent;
+			ingest(concurrent);
+			check(concurrent.size() == g.size() && concurrent.edgeCount() == g.edgeCount(), prefix + "concurrent addEdge", "counts differ from Graph");
+			check(sameEdges(freeze(concurrent), jvn::freeze(g), false), prefix + "concurrent addEdge", "frozen edges differ from Graph");
+		}
+
+		// Both readers have to give the edges of the graph built from the same list, in either format
+		if constexpr (std::is_integral<V>::value)
+		{
+			std::string edge_list, matrix_market;
+			{
+				std::ostringstream out, market;
+				market << "%%MatrixMarket matrix coordinate " << (Weighted ? "integer" : "pattern") << " general\n"
+					<< vertex_count << ' ' << vertex_count << ' ' << edges.size() << '\n';
+				for (const auto& edge : edges)
+				{
+					out << std::get<0>(edge) << ' ' << std::get<1>(edge);
+					market << std::get<0>(edge) + 1 << ' ' << std::get<1>(edge) + 1;
+					if constexpr (Weighted)
+					{
+						out << ' ' << std::get<2>(edge);
+						market << ' ' << std::get<2>(edge);
+					}
+					out << '\n';
+					market << '\n';
+				}
+				edge_list = out.str();
+				matrix_market = market.str();
+			}
+			const auto frozen = jvn::freeze(g);
+			run(options, prefix + "readEdgeList", edges.size(), [&](Timer& timer)
+			{
+				std::istringstream in(edge_list);
+				graph_type read;
+				timer.start();
+				jvn::readEdgeList(in, read, jvn::EdgeListFormat::edge_list, pool);
+				timer.stop();
+				check(sameEdges(jvn::freeze(read), frozen), prefix + "readEdgeList", "read edges differ from Graph");
+			});
+			run(options, prefix + "readCsrEdgeList", edges.size(), [&](Timer& timer)
+			{
+				std::istringstream in(edge_list);
+				timer.start();
+				auto read = jvn::readCsrEdgeList<csr_type>(in, jvn::EdgeListFormat::edge_list, pool);
+				timer.stop();
+				check(sameEdges(read, frozen), prefix + "readCsrEdgeList", "read edges differ from Graph");
+			});
+			if (options.filter.empty() || (prefix + "readCsrEdgeList").find(options.filter) != std::string::npos)
+			{
+				std::istringstream in(matrix_market);
+				check(sameEdges(jvn::readCsrEdgeList<csr_type>(in, jvn::EdgeListFormat::matrix_market, pool), frozen),
+					prefix + "readCsrEdgeList", "Matrix Market edges differ from Graph");
+				auto rejects = [&](const char* file, jvn::EdgeListFormat format)
+				{
+					return throws([&]
+					{
+						std::istringstream in(file);
+						jvn::readCsrEdgeList<csr_type>(in, format);
+					});
+				};
+				check(rejects("%%MatrixMarket matrix array real general\n2 2\n", jvn::EdgeListFormat::matrix_market)
+					&& rejects("1 2 3\n", jvn::EdgeListFormat::matrix_market) && rejects("1 x\n", jvn::EdgeListFormat::edge_list)
+					&& rejects("%%MatrixMarket matrix coordinate integer general\n3 3 1\n9 1 1\n", jvn::EdgeListFormat::matrix_market)
+					&& (Directed || rejects("%%MatrixMarket matrix coordinate integer skew-symmetric\n2 2 1\n2 1 5\n", jvn::EdgeListFormat::matrix_market)),
+					prefix + "readCsrEdgeList", "accepted a malformed file");
+			}
+		}
+
+		// The vertex values are the dense ids, every vertex has to keep the edges and weights it has in the graph
+		if constexpr (std::is_integral<V>::value)
+		{
+			using dense_type = jvn::DenseGraph<Directed, Weighted>;
+			std::vector<typename dense_type::edge_type> dense_edges;
+			dense_edges.reserve(edges.size());
+			for (const auto& edge : edges)
+			{
+				if constexpr (Weighted)
+					dense_edges.emplace_back(std::get<0>(edge), std::get<1>(edge), std::get<2>(edge));
+				else
+					dense_edges.emplace_back(std::get<0>(edge), std::get<1>(edge));
+			}
+			run(options, prefix + "dense addEdges", edges.size(), [&](Timer& timer)
+			{
+				timer.start();
+				dense_type dense;
+				dense.addEdges(dense_edges.begin(), dense_edges.end());
+				timer.stop();
+				g_sink = dense.edgeCount();
+			});
+
+			const auto dense = buildGraph<dense_type>(dense_edges);
+			run(options, prefix + "dense findEdge hit", edges.size(), [&](Timer& timer)
+			{
+				std::size_t found = 0;
+				timer.start();
+				for (const auto& edge : dense_edges)
+					found += dense.findEdge(edge) != dense.edge_end();
+				timer.stop();
+				g_sink = found;
+				check(found == dense_edges.size(), prefix + "dense findEdge hit", "missed an added edge");
+			});
+			// Every second edge goes, hubs lose theirs one by one through the edge index
+			run(options, prefix + "dense removeEdge", dense_edges.size() / 2, [&](Timer& timer)
+			{
+				dense_type copy(dense);
+				std::size_t removed = 0;
+				timer.start();
+				for (std::size_t i = 0; i < dense_edges.size(); i += 2)
+					removed += copy.removeEdge(dense_edges[i]);
+				timer.stop();
+				g_sink = removed;
+				// Graph with the same removals decides which edges are left, mirrors and duplicates included
+				graph_type expected(g);
+				for (std::size_t i = 0; i < edges.size(); i += 2)
+					expected.removeEdge(edges[i]);
+				bool same = copy.edgeCount() == expected.edgeCount();
+				for (std::size_t i = 0; same && i < dense_edges.size(); ++i)
+					same = (copy.findEdge(dense_edges[i]) != copy.edge_end()) == (expected.findEdge(edges[i]) != expected.edge_end());
+				check(same, prefix + "dense removeEdge", "edges differ after removal");
+			});
+			if (options.filter.empty() || (prefix + "dense addEdges").find(options.filter) != std::string::npos)
+			{
+				check(dense.edgeCount() == g.edgeCount(), prefix + "dense addEdges", "edge count differs from Graph");
+				check(throws([&]
+				{
+					dense_type copy(dense);
+					typename dense_type::edge_type edge;
+					std::get<0>(edge) = dense_type::npos;
+					copy.addEdge(edge);
+				}), prefix + "dense addEdges", "accepted npos as a vertex id");
+				const auto frozen = jvn::freeze(g);
+				const auto dense_frozen = freeze(dense);
+				bool same = dense_frozen.edgeCount() == frozen.edgeCount();
+				std::vector<std::tuple<std::size_t, int>> row, dense_row;
+				for (std::size_t id = 0; same && id < frozen.size(); ++id)
+				{
+					const auto vertex = std::size_t(frozen.vertices()[id]);
+					row.clear();
+					dense_row.clear();
+					for (auto edge = frozen.offsets()[id]; edge != frozen.offsets()[id + 1]; ++edge)
+						row.emplace_back(frozen.vertices()[frozen.neighbors()[edge]], Weighted ? frozen.weights()[edge] : 0);
+					for (auto edge = dense_frozen.offsets()[vertex]; edge != dense_frozen.offsets()[vertex + 1]; ++edge)
+						dense_row.emplace_back(dense_frozen.neighbors()[edge], Weighted ? dense_frozen.weights()[edge] : 0);
+					std::sort(row.begin(), row.end());
+					std::sort(dense_row.begin(), dense_row.end());
+					same = row == dense_row;
+				}
+				check(same, prefix + "dense addEdges", "frozen edges differ from Graph");
+			}
+		}
+
+		// Half of the edges make the base, the rest arrive in published batches
+		using delta_type = jvn::DeltaCsrGraph<V, Directed, Weighted>;
+		const std::size_t delta_batch = 1024;
+		const auto half = edges.begin() + edges.size() / 2;
+		const auto delta_base = buildGraph<graph_type>({ edges.begin(), half });
+		auto ingestDelta = [&](delta_type& delta)
+		{
+			for (auto first = half; first != edges.end(); )
+			{
+				auto last = edges.end() - first > std::ptrdiff_t(delta_batch) ? first + delta_batch : edges.end();
+				delta.addEdges(first, last);
+				first = last;
+			}
+		};
+		run(options, prefix + "delta addEdges", edges.end() - half, [&](Timer& timer)
+		{
+			delta_type delta(delta_base);
+			timer.start();
+			ingestDelta(delta);
+			timer.stop();
+			g_sink = delta.snapshot().edgeCount();
+		});
+		run(options, prefix + "delta compact", edges.size(), [&](Timer& timer)
+		{
+			delta_type delta(delta_base);
+			ingestDelta(delta);
+			timer.start();
+			delta.compact();
+			timer.stop();
+			g_sink = delta.snapshot().base().edgeCount();
+		});
+		if (options.filter.empty() || (prefix + "delta addEdges").find(options.filter) != std::string::npos)
+		{
+			delta_type delta(delta_base);
+			const auto before = delta.snapshot();
+			ingestDelta(delta);
+			check(before.edgeCount() == delta_base.edgeCount() && before.size() == delta_base.size(), prefix + "delta addEdges",
+				"an older snapshot saw a later publish");
+			const auto after = delta.snapshot();
+			check(after.size() == g.size() && after.edgeCount() == g.edgeCount(), prefix + "delta addEdges", "counts differ from Graph");
+			check(std::all_of(edges.begin(), edges.end(), [&](const auto& edge) { return after.findEdge(edge) != after.edge_end(); }),
+				prefix + "delta addEdges", "missed a published edge");
+
+			// An edge between two new vertices stays invisible until published
+			typename graph_type::edge_type extra;
+			std::get<0>(extra) = makeVertex<V>(vertex_count);
+			std::get<1>(extra) = makeVertex<V>(vertex_count + 1);
+			if constexpr (Weighted)
+				std::get<2>(extra) = 1;
+			delta.addEdge(extra);
+			check(delta.snapshot().findEdge(extra) == after.edge_end() && delta.snapshot().size() == g.size(), prefix + "delta addEdges",
+				"saw an edge before its publish");
+			delta.publish();
+			check(delta.snapshot().findEdge(extra) != after.edge_end(), prefix + "delta addEdges", "missed an edge after its publish");
+
+			delta.compact();
+			graph_type expected(g);
+			expected.addEdge(extra);
+			const auto compacted = delta.snapshot();
+			check(compacted.overlayEdgeCount() == 0 && sameEdges(compacted.base(), jvn::freeze(expected)), prefix + "delta addEdges",
+				"compacted base differs from Graph");
+
+			// A dropped future doesn't wait, the graph going away does, and a kept one sees the result
+			{
+				delta_type dropped(delta_base);
+				ingestDelta(dropped);
+				dropped.compactAsync();
+			}
+			delta_type async(delta_base);
+			ingestDelta(async);
+			async.compactAsync().get();
+			check(async.snapshot().overlayEdgeCount() == 0 && async.snapshot().edgeCount() == g.edgeCount(), prefix + "delta addEdges",
+				"compactAsync left layers behind");
+		}
+
+		run(options, prefix + "removeEdge", edges.size(), [&](Timer& timer)
+		{
+			graph_type copy(g);
+			std::size_t removed = 0;
+			timer.start();
+			for (auto& edge : edges)
+				removed += copy.removeEdge(edge);
+			timer.stop();
+			g_sink = removed;
+		});
+
+		const auto source = g.findVertex(std::get<0>(edges.front()));
+
+		run(options, prefix + "bfs", edges.size(), [&](Timer& timer)
+		{
+			std::size_t reached = 0;
+			typename graph_type::traversal_workspace workspace;
+			timer.start();
+			g.bfs(source, [&](auto) { ++reached; return true; }, workspace);
+			timer.stop();
+			g_sink = reached;
+		});
+
+		run(options, prefix + "shortestPaths", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto paths = g.shortestPaths(source);
+			timer.stop();
+			g_sink = std::get<0>(paths).size();
+		});
+
+		run(options, prefix + "components", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto components = g.connectedComponents();
+			timer.stop();
+			g_sink = std::get<0>(components);
+		});
+
+		run(options, prefix + "freeze", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto csr = jvn::freeze(g);
+			timer.stop();
+			g_sink = csr.size();
+		});
+
+		const auto csr = jvn::freeze(g);
+
+		run(options, prefix + "compress", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto compressed = jvn::compress(g);
+			timer.stop();
+			g_sink = compressed.encodedSize();
+		});
+
+		const auto compressed = jvn::compress(g);
+		run(options, prefix + "iterate compressed", edges.size(), [&](Timer& timer)
+		{
+			std::size_t count = 0;
+			timer.start();
+			for (auto vertex = compressed.begin(); vertex != compressed.end(); ++vertex)
+				for (auto edge = vertex.getEdges(); edge != compressed.edge_end(); ++edge)
+					count += edge.getEndVertex().getId();
+			timer.stop();
+			g_sink = count;
+		});
+		if (options.filter.empty() || (prefix + "compress").find(options.filter) != std::string::npos)
+		{
+			// Both decoders have to give back the neighbor set of every vertex of the snapshot, in target order
+			using weight_type = typename csr_type::weight_type;
+			std::vector<std::tuple<std::size_t, weight_type>> decoded, visited, expected;
+			bool same = compressed.size() == csr.size() && compressed.edgeCount() == csr.edgeCount();
+			for (auto vertex = compressed.begin(); same && vertex != compressed.end(); ++vertex)
+			{
+				const auto id = vertex.getId();
+				decoded.clear();
+				visited.clear();
+				expected.clear();
+				for (auto edge = vertex.getEdges(); edge != compressed.edge_end(); ++edge)
+					if constexpr (Weighted)
+						decoded.emplace_back(edge.getEndVertex().getId(), edge.weight());
+					else
+						decoded.emplace_back(edge.getEndVertex().getId(), weight_type(0));
+				if constexpr (Weighted)
+					compressed.forEachNeighbor(id, [&](std::size_t target, const weight_type& weight) { visited.emplace_back(target, weight); });
+				else
+					compressed.forEachNeighbor(id, [&](std::size_t target) { visited.emplace_back(target, weight_type(0)); });
+				for (auto edge = csr.offsets()[id]; edge != csr.offsets()[id + 1]; ++edge)
+					if constexpr (Weighted)
+						expected.emplace_back(csr.neighbors()[edge], csr.weights()[edge]);
+					else
+						expected.emplace_back(csr.neighbors()[edge], weight_type(0));
+				std::sort(expected.begin(), expected.end());
+				same = *vertex == csr.vertices()[id] && compressed.degree(id) == csr.degree(id)
+					&& std::is_sorted(decoded.begin(), decoded.end()) && decoded == expected && visited == expected;
+			}
+			check(same, prefix + "compress", "decoded neighbors differ from the snapshot");
+		}
+
+		std::string csr_file;
+		{
+			std::ostringstream out;
+			jvn::saveCsr(csr, out);
+			csr_file = out.str();
+		}
+		run(options, prefix + "saveCsr", edges.size(), [&](Timer& timer)
+		{
+			std::ostringstream out;
+			timer.start();
+			jvn::saveCsr(csr, out);
+			timer.stop();
+			g_sink = out.str().size();
+		});
+		run(options, prefix + "loadCsr", edges.size(), [&](Timer& timer)
+		{
+			std::istringstream in(csr_file);
+			timer.start();
+			auto loaded = jvn::loadCsr<csr_type>(in);
+			timer.stop();
+			check(sameArrays(loaded, csr), prefix + "loadCsr", "loaded snapshot differs from the saved one");
+		});
+		if (options.filter.empty() || (prefix + "loadCsr").find(options.filter) != std::string::npos)
+		{
+			// Damaged or mismatching files have to be rejected rather than read
+			auto rejects = [&](std::string file)
+			{
+				return throws([&]
+				{
+					std::istringstream in(file);
+					jvn::loadCsr<csr_type>(in);
+				});
+			};
+			auto bad_magic = csr_file;
+			bad_magic[0] = 'X';
+			auto bad_type = csr_file;
+			reinterpret_cast<jvn::CsrFileHeader*>(bad_type.data())->flags ^= jvn::csr_flag_directed;
+			check(rejects(bad_magic) && rejects(bad_type) && rejects(csr_file.substr(0, csr_file.size() / 2))
+				&& rejects(csr_file.substr(0, sizeof(jvn::CsrFileHeader) / 2)), prefix + "loadCsr", "accepted a damaged file");
+
+			// Unseekable streams can't bound the counts up front, the short read has to stop them
+			auto huge = csr_file;
+			auto& header = *reinterpret_cast<jvn::CsrFileHeader*>(huge.data());
+			header = jvn::makeCsrHeader<typename csr_type::vertex_type, csr_type::directed, csr_type::weighted,
+				typename csr_type::weight_type, jvn::VertexSerializer<typename csr_type::vertex_type>>(header.vertex_count,
+				std::uint64_t(1) << 40, header.vertices_size);
+			bool rejected = false;
+			try
+			{
+				PipeBuffer buffer(huge);
+				std::istream in(&buffer);
+				jvn::loadCsr<csr_type>(in);
+			}
+			catch (const std::runtime_error&)
+			{
+				rejected = true;
+			}
+			check(rejected, prefix + "loadCsr", "allocated for the counts of a damaged pipe");
+		}
+#ifdef JVN_HAS_MMAP
+		if (options.filter.empty() || (prefix + "mapCsr").find(options.filter) != std::string::npos)
+		{
+			const std::string path = "GraphBenchmark.csr";
+			jvn::saveCsr(csr, path);
+			run(options, prefix + "mapCsr", edges.size(), [&](Timer& timer)
+			{
+				timer.start();
+				jvn::MappedCsrGraph<V, Directed, Weighted> mapped(path);
+				mapped.verify();
+				timer.stop();
+				check(sameArrays(mapped, csr), prefix + "mapCsr", "mapped snapshot differs from the saved one");
+			});
+			std::remove(path.c_str());
+		}
+#endif
+
+		// Every vertex is owned once, every edge lives on the shard of its source and maps back to the snapshot
+		const std::size_t shard_count = 4;
+		run(options, prefix + "partition", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto owners = jvn::partitionVertices(csr, shard_count);
+			auto shards = jvn::makeShards(csr, owners, shard_count);
+			timer.stop();
+			g_sink = jvn::edgeCut(csr, owners);
+		});
+		const auto owners = jvn::partitionVertices(csr, shard_count);
+		const auto shards = jvn::makeShards(csr, owners, shard_count);
+		if (options.filter.empty() || (prefix + "partition").find(options.filter) != std::string::npos)
+		{
+			std::vector<std::size_t> owned(csr.size(), 0);
+			std::size_t edge_count = 0, cut = 0;
+			bool same = shards.size() == shard_count;
+			for (const auto& shard : shards)
+			{
+				const auto& local = shard.graph();
+				edge_count += local.edgeCount();
+				for (std::size_t id = 0; same && id < local.size(); ++id)
+				{
+					const auto global = shard.globalId(id);
+					same = shard.localId(global) == id && owners[global] == shard.owner(id) && local.vertices()[id] == csr.vertices()[global];
+					if (shard.isGhost(id))
+						continue;
+					++owned[global];
+					same = same && local.degree(id) == csr.degree(global);
+					for (auto edge = local.offsets()[id], original = csr.offsets()[global]; same && edge != local.offsets()[id + 1]; ++edge, ++original)
+					{
+						cut += shard.isGhost(local.neighbors()[edge]);
+						same = shard.globalId(local.neighbors()[edge]) == csr.neighbors()[original]
+							&& (!Weighted || local.weights()[edge] == csr.weights()[original]);
+					}
+				}
+			}
+			check(same, prefix + "partition", "shard tables or edges differ from the snapshot");
+			check(std::all_of(owned.begin(), owned.end(), [](std::size_t count) { return count == 1; }), prefix + "partition",
+				"a vertex isn't owned exactly once");
+			check(edge_count == csr.edgeCount() && cut == jvn::edgeCut(csr, owners), prefix + "partition", "edge counts differ from the snapshot");
+		}
+		run(options, prefix + "saveShard", edges.size(), [&](Timer& timer)
+		{
+			// All shards in one stream, every load has to stop right after its shard
+			using shard_type = std::decay_t<decltype(shards[0])>;
+			std::vector<shard_type> loaded;
+			timer.start();
+			std::stringstream file;
+			for (const auto& shard : shards)
+				jvn::saveShard(shard, file);
+			for (std::size_t shard = 0; shard < shard_count; ++shard)
+				loaded.push_back(jvn::loadShard<shard_type>(file));
+			timer.stop();
+			for (std::size_t shard = 0; shard < shard_count; ++shard)
+			{
+				const auto& lhs = loaded[shard];
+				const auto& rhs = shards[shard];
+				check(lhs.shardId() == rhs.shardId() && lhs.shardCount() == rhs.shardCount() && lhs.globalSize() == rhs.globalSize()
+					&& lhs.ownedCount() == rhs.ownedCount() && lhs.globalIds() == rhs.globalIds() && lhs.ghostOwners() == rhs.ghostOwners()
+					&& sameArrays(lhs.graph(), rhs.graph()), prefix + "saveShard", "loaded shard differs from the saved one");
+			}
+		});
+		if (options.filter.empty() || (prefix + "saveShard").find(options.filter) != std::string::npos)
+		{
+			// Counts the file can't hold have to be rejected before anything is allocated for them
+			using shard_type = std::decay_t<decltype(shards[0])>;
+			std::stringstream out;
+			jvn::saveShard(shards[0], out);
+			const auto file = out.str();
+			auto huge = file;
+			auto header = reinterpret_cast<jvn::ShardFileHeader*>(huge.data());
+			header->vertex_count = header->owned_count = std::uint64_t(1) << 40;
+			header->graph_pos = jvn::alignCsrSection(sizeof(jvn::ShardFileHeader) + header->vertex_count * sizeof(std::size_t));
+			auto rejects = [&](const std::string& damaged)
+			{
+				try
+				{
+					std::istringstream in(damaged);
+					jvn::loadShard<shard_type>(in);
+				}
+				catch (const std::runtime_error&)
+				{
+					return true;
+				}
+				return false;
+			};
+			check(rejects(huge) && rejects(file.substr(0, file.size() / 2)), prefix + "saveShard", "accepted a damaged shard file");
+		}
+		run(options, prefix + "parallelBfs", edges.size(), [&](Timer& timer)
+		{
+			timer.start();
+			auto distances = jvn::parallelBfs(csr, source.getId(), pool);
+			timer.stop();
+			g_sink = distances.size();
+		});
+
+		// 64 two hop queries from spread out sources as one batch, items are the reached vertices
+		std::vector<std::size_t> sources;
+		for (std::size_t i = 0; i < jvn::MultiSourceBfsWorkspace::max_sources; ++i)
+			sources.push_back(i * csr.size() / jvn::MultiSourceBfsWorkspace::max_sources);
+		jvn::MultiSourceBfsWorkspace k_hop_workspace;
+		std::size_t reached = 0;
+		for (auto& hop_set : jvn::kHopNeighborhoods(csr, sources, 2, k_hop_workspace))
+			reached += hop_set.vertices.size();
+		run(options, prefix + "kHop", reached, [&](Timer& timer)
+		{
+			timer.start();
+			auto hop_sets = jvn::kHopNeighborhoods(csr, sources, 2, k_hop_workspace);
+			timer.stop();
+			g_sink = hop_sets.size();
+		});
+
+		run(options, prefix + "pageRank", edges.size(), [&](Timer& timer)
+		{
+			jvn::PageRankOptions page_rank;
+			page_rank.max_iterations = 10;
+			page_rank.tolerance = 0;
+			timer.start();
+			auto ranks = jvn::pageRank(csr, pool, page_rank);
+			timer.stop();
+			g_sink = std::get<1>(ranks);
+		});
+	}
+
+	template <class V>
+	void benchmarkVertexType(const Options& options, const std::string& generator, const jvn::bench::edge_list& edges,
+		std::uint64_t vertex_count, jvn::ThreadPool& pool)
+	{
+		benchmarkGraph<V, false, false>(options, generator, edges, vertex_count, pool);
+		benchmarkGraph<V, false, true>(options, generator, edges, vertex_count, pool);
+		benchmarkGraph<V, true, false>(options, generator, edges, vertex_count, pool);
+		benchmarkGraph<V, true, true>(options, generator, edges, vertex_count, pool);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (argc > 1)
+		options.scale = unsigned(std::strtoul(argv[1], nullptr, 10));
+	if (argc > 2)
+		options.repetitions = std::max(1u, unsigned(std::strtoul(argv[2], nullptr, 10)));
+	if (argc > 3)
+		options.filter = argv[3];
+	if (options.scale == 0 || options.scale > 30)
+	{
+		std::fprintf(stderr, "usage: %s [scale = 14] [repetitions = 5] [filter]\n", argv[0]);
+		return 1;
+	}
+
+	const std::uint64_t vertex_count = std::uint64_t(1) << options.scale;
+	const std::uint64_t edge_count = 8 * vertex_count;
+	const std::uint64_t side = std::uint64_t(1) << (options.scale / 2);
+
+	struct Input
+	{
+		std::string name;
+		jvn::bench::edge_list edges;
+		std::uint64_t vertex_count;
+	};
+	const Input inputs[] = {
+		{ "rmat", jvn::bench::rmat(options.scale, edge_count, 1), vertex_count },
+		{ "erdos-renyi", jvn::bench::erdosRenyi(vertex_count, edge_count, 2), vertex_count },
+		{ "grid", jvn::bench::grid(side, vertex_count / side), vertex_count },
+		{ "power-law", jvn::bench::powerLaw(vertex_count, edge_count, 2.1, 3), vertex_count },
+	};
+
+	jvn::ThreadPool pool;
+	std::printf("scale %u, %u repetitions, %zu threads\n", options.scale, options.repetitions, pool.size());
+	std::printf("%-48s %10s %10s %10s %12s %12s\n", "case", "min ms", "median ms", "ns/item", "retained KiB", "peak KiB");
+	for (auto& input : inputs)
+	{
+		benchmarkVertexType<int>(options, input.name, input.edges, input.vertex_count, pool);
+		benchmarkVertexType<std::string>(options, input.name, input.edges, input.vertex_count, pool);
+	}
+	return 0;
+}